@@ -0,0 +1,79 @@
+// benchmark: conversion of the screen into ARGB8888 pixels (as done by the
+// SDL2 renderer to fill its texture) at different resolution modes.
+// It compares the per-pixel loop to the lookup table kernel of "bitmap.h".
+#define  KONPU_PLATFORM_POSIX
+#define  KONPU_IMPLEMENTATION
+#include "konpu.h"
+#include <stdio.h>
+#include <time.h>
+
+#define MAX_MODE     8
+#define FRAMES       200
+#define MAX_WIDTH    (KONPU_RES_ASPECT_X * MAX_MODE)
+#define MAX_HEIGHT   (KONPU_RES_ASPECT_Y * MAX_MODE)
+
+static uint64_t       glyphs[MAX_WIDTH * MAX_HEIGHT];
+static uint32_t       pixels[GLYPH_WIDTH * MAX_WIDTH * GLYPH_HEIGHT * MAX_HEIGHT];
+static unsigned char  bits[GLYPH_HEIGHT * MAX_WIDTH];
+static argbTable      table;
+
+static double now(void)
+{  struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// the original loop of the SDL2 renderer: a branch per pixel
+static void convert_loop(canvas cvas)
+{  uint32_t *p = pixels;
+   for (int y = 0; y < GLYPH_HEIGHT * cvas.height; y++) {
+       for (int x = 0; x < cvas.width; x++) {
+           uint64_t glyph = canvas_glyph(cvas, x, y / GLYPH_HEIGHT);
+           unsigned char line = glyph_line(glyph, y % GLYPH_HEIGHT);
+           for (int i = (GLYPH_WIDTH - 1); i >= 0; i--)
+               *p++ = (line & (1 << i)) ? UINT32_C(0x00cccc00) : UINT32_C(0x00000080);
+       }
+   }
+}
+
+// the lookup table kernel
+static void convert_table(canvas cvas)
+{  uint32_t *p = pixels;
+   for (int y = 0; y < cvas.height; y++) {
+       bitmap_fromCanvasRow(bits, cvas.width, cvas, y);
+       for (int line = 0; line < GLYPH_HEIGHT; line++) {
+           bitmap_toARGB(&table, bits + line * cvas.width, cvas.width, p);
+           p += GLYPH_WIDTH * cvas.width;
+       }
+   }
+}
+
+static double bench(void (*convert)(canvas), canvas cvas)
+{  double t = now();
+   for (int i = 0; i < FRAMES; i++)
+       convert(cvas);
+   return (now() - t) * 1000. / FRAMES;
+}
+
+int main(int argc, char **argv)
+{  (void)argc; (void)argv;  // not using argc/argv
+
+   random_init(1234);
+   for (size_t i = 0; i < ARRAY_SIZE(glyphs); i++)
+       glyphs[i] = random();
+   argbTable_init(&table, UINT32_C(0x00cccc00), UINT32_C(0x00000080));
+
+   printf("mode  resolution   loop (ms)  table (ms)  speedup\n");
+   for (int mode = 1; mode <= MAX_MODE; mode++) {
+       canvas cvas = { .glyphs = glyphs,
+                       .width  = KONPU_RES_ASPECT_X * mode,
+                       .height = KONPU_RES_ASPECT_Y * mode,
+                       .stride = KONPU_RES_ASPECT_X * mode };
+       double t_loop  = bench(&convert_loop,  cvas);
+       double t_table = bench(&convert_table, cvas);
+       printf("%4d  %4dx%-4d  %10.3f  %10.3f  %6.2fx\n", mode,
+              GLYPH_WIDTH * cvas.width, GLYPH_HEIGHT * cvas.height,
+              t_loop, t_table, t_loop / t_table);
+   }
+   return 0;
+}
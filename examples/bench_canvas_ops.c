@@ -0,0 +1,105 @@
+// benchmark: the bulk raster operations between canvases (`canvas_and`, ...)
+// compared to the naive loops over `canvas_glyph`, on the whole screen (where
+// the glyphs of each canvas are one contiguous run) and on a crop of it (one
+// run per row). It also checks that both give the same glyphs.
+#define  KONPU_PLATFORM_POSIX
+#define  KONPU_RES_MODE 8
+#define  KONPU_IMPLEMENTATION
+#include "konpu.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAMES  5000
+
+// the operands (with the same dimensions as the screen)
+static uint64_t a_glyphs[GRID_WIDTH * GRID_HEIGHT];
+static uint64_t b_glyphs[GRID_WIDTH * GRID_HEIGHT];
+static uint64_t m_glyphs[GRID_WIDTH * GRID_HEIGHT];
+static uint64_t check[GRID_WIDTH * GRID_HEIGHT];
+
+static canvas a, b, m;
+
+// the naive loops
+#define NAIVE(name, expr)                                              \
+   static void name(canvas dst)                                        \
+   {  for (int y = 0; y < dst.height; y++)                             \
+          for (int x = 0; x < dst.width; x++)                          \
+              canvas_glyph(dst, x,y) = (expr);                         \
+   }
+#define A   canvas_glyph(a, x,y)
+#define B   canvas_glyph(b, x,y)
+#define M   canvas_glyph(m, x,y)
+NAIVE(naive_and   , A & B)
+NAIVE(naive_or    , A | B)
+NAIVE(naive_xor   , A ^ B)
+NAIVE(naive_andnot, A & ~B)
+NAIVE(naive_not   , ~A)
+NAIVE(naive_merge , UINT_MERGE(A, B, M))
+#undef A
+#undef B
+#undef M
+
+// the bulk raster operations (with the same prototype)
+static void bulk_and   (canvas dst) { canvas_and(dst, a, b);      }
+static void bulk_or    (canvas dst) { canvas_or(dst, a, b);       }
+static void bulk_xor   (canvas dst) { canvas_xor(dst, a, b);      }
+static void bulk_andnot(canvas dst) { canvas_andnot(dst, a, b);   }
+static void bulk_not   (canvas dst) { canvas_not(dst, a);         }
+static void bulk_merge (canvas dst) { canvas_merge(dst, a, b, m); }
+
+// time of an operation (in microseconds per frame)
+static double bench(void (*op)(canvas), canvas dst)
+{  uint64_t t = clock_ns();
+   for (int i = 0; i < FRAMES; i++)
+       op(dst);
+   return (clock_ns() - t) / 1e3 / FRAMES;
+}
+
+int main(int argc, char **argv)
+{  (void)argc; (void)argv;  // not using argc/argv
+
+   static const struct { const char *name; void (*naive)(canvas); void (*bulk)(canvas); }
+   ops[] = { { "and   ", &naive_and   , &bulk_and    },
+             { "or    ", &naive_or    , &bulk_or     },
+             { "xor   ", &naive_xor   , &bulk_xor    },
+             { "andnot", &naive_andnot, &bulk_andnot },
+             { "not   ", &naive_not   , &bulk_not    },
+             { "merge ", &naive_merge , &bulk_merge  } };
+
+   random_init(1234);
+   for (int i = 0; i < GRID_WIDTH * GRID_HEIGHT; i++) {
+       a_glyphs[i] = random();
+       b_glyphs[i] = random();
+       m_glyphs[i] = random();
+   }
+
+   fprintf(stderr, "screen: %dx%d glyphs, AVX2: %s, SSE2: %s\n", GRID_WIDTH, GRID_HEIGHT,
+           (cpu_hasAVX2()) ? "yes" : "no", (cpu_hasSSE2()) ? "yes" : "no");
+   fprintf(stderr, "op      area    naive (us)  bulk (us)  speedup\n");
+
+   // the whole screen, then a crop of it (the operands are cropped alike)
+   rect crops[] = { { .x = 0, .y = 0, .w = GRID_WIDTH,     .h = GRID_HEIGHT     },
+                    { .x = 3, .y = 2, .w = GRID_WIDTH - 7, .h = GRID_HEIGHT - 5 } };
+   for (size_t c = 0; c < ARRAY_SIZE(crops); c++) {
+       canvas full = { .glyphs = a_glyphs, .width = GRID_WIDTH, .height = GRID_HEIGHT, .stride = GRID_WIDTH };
+       a = canvas_crop(full, crops[c]);
+       full.glyphs = b_glyphs;   b = canvas_crop(full, crops[c]);
+       full.glyphs = m_glyphs;   m = canvas_crop(full, crops[c]);
+       canvas dst = canvas_crop(screen, crops[c]);
+
+       for (size_t i = 0; i < ARRAY_SIZE(ops); i++) {
+           canvas_fill(screen, 0);
+           double t_naive = bench(ops[i].naive, dst);
+           memcpy(check, screen.glyphs, sizeof(check));
+           canvas_fill(screen, 0);
+           double t_bulk  = bench(ops[i].bulk, dst);
+           if (memcmp(check, screen.glyphs, sizeof(check))) {
+              fprintf(stderr, "error: the operations differ\n");
+              return 1;
+           }
+           fprintf(stderr, "%s  %-6s  %10.2f  %9.2f  %6.2fx\n", ops[i].name,
+                   (c == 0) ? "screen" : "crop", t_naive, t_bulk, t_naive / t_bulk);
+       }
+   }
+   return 0;
+}
@@ -0,0 +1,95 @@
+// benchmark: `canvas_line` (drawing by horizontal and vertical runs of up to 8
+// pixels per store) compared to drawing lines pixel by pixel (the Bresenham's
+// loop it replaced, copied below) for several kinds of random lines, including
+// lines going far off the canvas (which `canvas_line` clips first). It also
+// checks that both draw the same pixels.
+#define  KONPU_PLATFORM_POSIX
+#define  KONPU_RES_MODE 8
+#define  KONPU_IMPLEMENTATION
+#include "konpu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINES  100000
+
+// the lines (as x0,y0,x1,y1), and a copy of the screen for the checks
+static int      lines[LINES][4];
+static uint64_t check[GRID_WIDTH * GRID_HEIGHT];
+
+// reference: Bresenham's line algorithm, pixel by pixel
+static void line_pixels(canvas cvas, int x0, int y0, int x1, int y1)
+{  int dx  = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+   int dy  = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+   int err = (dx>dy ? dx : -dy)/2, e2;
+   for(;;) {
+      if (x0 >= 0  &&  x0 < GLYPH_WIDTH  * cvas.width  &&
+          y0 >= 0  &&  y0 < GLYPH_HEIGHT * cvas.height)
+         canvas_glyph(cvas, x0 / 8, y0 / 8) |= glyph_fromPixel(x0 % 8, y0 % 8);
+      if (x0 == x1 && y0 == y1) break;
+      e2 = err;
+      if (e2 >-dx) { err -= dy; x0 += sx; }
+      if (e2 < dy) { err += dx; y0 += sy; }
+   }
+}
+
+// whether both draw the same pixels for each of the first `count` lines
+static bool same(int count)
+{  for (int i = 0; i < count; i++) {
+       canvas_fill(screen, 0);
+       line_pixels(screen, lines[i][0], lines[i][1], lines[i][2], lines[i][3]);
+       memcpy(check, screen.glyphs, sizeof(check));
+       canvas_fill(screen, 0);
+       canvas_line(screen, lines[i][0], lines[i][1], lines[i][2], lines[i][3]);
+       if (memcmp(check, screen.glyphs, sizeof(check)))
+          return false;
+   }
+   return true;
+}
+
+// time to draw all the lines (in nanoseconds per line)
+static double bench(void (*draw)(canvas, int, int, int, int))
+{  canvas_fill(screen, 0);
+   uint64_t t = clock_ns();
+   for (int i = 0; i < LINES; i++)
+       draw(screen, lines[i][0], lines[i][1], lines[i][2], lines[i][3]);
+   return (double)(clock_ns() - t) / LINES;
+}
+
+int main(int argc, char **argv)
+{  (void)argc; (void)argv;  // not using argc/argv
+
+   static const char *kinds[] = { "horizontal", "vertical  ", "shallow   ",
+                                  "steep     ", "any       ", "off-canvas" };
+   fprintf(stderr, "screen: %dx%d pixels, %d lines per kind\n",
+           RES_WIDTH, RES_HEIGHT, LINES);
+   fprintf(stderr, "lines       pixels (ns)  runs (ns)  speedup\n");
+
+   random_init(1234);
+   for (size_t kind = 0; kind < ARRAY_SIZE(kinds); kind++) {
+       for (int i = 0; i < LINES; i++) {
+           int x0 = random() % RES_WIDTH,  x1 = random() % RES_WIDTH;
+           int y0 = random() % RES_HEIGHT, y1 = random() % RES_HEIGHT;
+           switch (kind) {
+              case 0: y1 = y0; break;
+              case 1: x1 = x0; break;
+              case 2: y1 = y0 + (y1 - y0) * abs(x1 - x0) / (2 * RES_HEIGHT); break;
+              case 3: x1 = x0 + (x1 - x0) * abs(y1 - y0) / (2 * RES_WIDTH);  break;
+              case 5: x0 = 9 * x0 - 4 * RES_WIDTH;  x1 = 9 * x1 - 4 * RES_WIDTH;
+                      y0 = 9 * y0 - 4 * RES_HEIGHT; y1 = 9 * y1 - 4 * RES_HEIGHT;
+                      break;
+           }
+           lines[i][0] = x0; lines[i][1] = y0;
+           lines[i][2] = x1; lines[i][3] = y1;
+       }
+       if (!same(1000)) {
+          fprintf(stderr, "error: the lines differ\n");
+          return 1;
+       }
+       double t_pixels = bench(&line_pixels);
+       double t_runs   = bench(&canvas_line);
+       fprintf(stderr, "%s  %11.1f  %9.1f  %6.2fx\n",
+               kinds[kind], t_pixels, t_runs, t_pixels / t_runs);
+   }
+   return 0;
+}
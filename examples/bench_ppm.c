@@ -0,0 +1,82 @@
+// benchmark: throughput (in frames per second) of the PPM renderer's encoder
+// at different zoom levels. It compares the original encoder (one `putc` per
+// byte) to the scanline-buffered one of the PPM renderer. The frames are
+// written to /dev/null (stdout is redirected there, results go to stderr),
+// so this measures the encoding and stdio's costs.
+#define  KONPU_PLATFORM_POSIX
+#define  KONPU_RES_MODE 2
+#define  KONPU_IMPLEMENTATION
+#include "konpu.h"
+#include <stdio.h>
+
+#define SECONDS   1.0  // duration of a measure
+#define out       stdout
+
+static double now(void)
+{  return clock_ns() / 1e9; }
+
+// the original encoder of the PPM renderer: a `putc` per byte
+static int render_putc(int zoomx, int zoomy)
+{  canvas cvas = screen;
+   fprintf(out, "P6\n%d %d\n255\n", zoomx * GLYPH_WIDTH  * cvas.width,
+                                    zoomy * GLYPH_HEIGHT * cvas.height);
+   for (int y = 0; y < GLYPH_HEIGHT * cvas.height; y++) {
+       for (int ny = 0; ny < zoomy; ny++) {
+           for (int x = 0; x < cvas.width; x++) {
+               uint64_t glyph = canvas_glyph(cvas, x, y/GLYPH_HEIGHT);
+               unsigned char line = glyph_line(glyph, y%GLYPH_HEIGHT);
+               for (int i = GLYPH_WIDTH - 1; i >= 0; i--) {
+                   for (int nx = 0; nx < zoomx; nx++) {
+                       if (line & (1 << i)) {
+                          putc(0xFF, out); putc(0xFF, out); putc(0x00, out);
+                       } else {
+                          putc(0x00, out); putc(0x00, out); putc(0x80, out);
+                       }
+                   }
+               }
+           }
+       }
+   }
+   fflush(out);
+   return ferror(out);
+}
+
+static double fps_putc(int zoom)
+{  int frames = 0;
+   double t = now(), end = t + SECONDS;
+   while (now() < end) { render_putc(zoom, zoom); frames++; }
+   return frames / (now() - t);
+}
+
+static double fps_renderer(int zoom)
+{  int frames = 0;
+   rendererPPM_init(zoom, zoom);
+   double t = now(), end = t + SECONDS;
+   while (now() < end) { render(); frames++; }
+   double fps = frames / (now() - t);
+   renderer_drop();
+   return fps;
+}
+
+int main(int argc, char **argv)
+{  (void)argc; (void)argv;  // not using argc/argv
+
+   if (freopen("/dev/null", "wb", stdout) == NULL) {
+      perror("/dev/null");
+      return 1;
+   }
+
+   random_init(1234);
+   for (int y = 0; y < screen.height; y++)
+      for (int x = 0; x < screen.width; x++)
+         canvas_glyph(screen, x,y) = random();
+
+   fprintf(stderr, "zoom  resolution   putc (fps)  scanline (fps)  speedup\n");
+   for (int zoom = 1; zoom <= 4; zoom *= 2) {
+       double a = fps_putc(zoom);
+       double b = fps_renderer(zoom);
+       fprintf(stderr, "%4d  %4dx%-4d  %10.1f  %14.1f  %6.2fx\n", zoom,
+              zoom * RES_WIDTH, zoom * RES_HEIGHT, a, b, b / a);
+   }
+   return 0;
+}
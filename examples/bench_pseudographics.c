@@ -0,0 +1,88 @@
+// benchmark: the kernels making the cells of the quadrants (2x2) and braille
+// (2x4) modes of the PseudoGraphics renderer from the glyphs of the screen.
+// It compares the portable kernel (mask and multiply) to the PEXT kernel which
+// is used on x86 cpus with BMI2. Then it measures the whole renderer (with the
+// kernel it selected), writing to /dev/null (stdout is redirected there,
+// results go to stderr), with the median and 99th percentile of its frames
+// from the statistics of the renderer.
+#define  KONPU_PLATFORM_POSIX
+#define  KONPU_RES_MODE 8
+#define  KONPU_IMPLEMENTATION
+#include "konpu.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAMES     2000
+#define MAX_CELLS  (GLYPH_WIDTH * GRID_WIDTH / 2 * GLYPH_HEIGHT * GRID_HEIGHT / 2)
+
+static unsigned char codes[MAX_CELLS];
+static unsigned char check[MAX_CELLS];
+
+// time of a kernel (in microseconds per frame)
+static double bench(void (*kernel)(unsigned char*, int), int height)
+{  uint64_t t = clock_ns();
+   for (int i = 0; i < FRAMES; i++)
+       kernel(codes, height);
+   return (clock_ns() - t) / 1e3 / FRAMES;
+}
+
+// time of the renderer (in microseconds per frame), and its statistics
+static double bench_render(rendererPseudoGraphicsMode mode, rendererStats *stats)
+{  if (rendererPseudoGraphics_init(mode))
+      return 0.;
+   uint64_t t = clock_ns();
+   for (int i = 0; i < FRAMES; i++)
+       render();
+   double us = (clock_ns() - t) / 1e3 / FRAMES;
+   *stats = renderer_getStats();
+   renderer_drop();
+   return us;
+}
+
+int main(int argc, char **argv)
+{  (void)argc; (void)argv;  // not using argc/argv
+
+   if (freopen("/dev/null", "wb", stdout) == NULL) {
+      perror("/dev/null");
+      return 1;
+   }
+
+   random_init(1234);
+   for (int y = 0; y < screen.height; y++)
+      for (int x = 0; x < screen.width; x++)
+         canvas_glyph(screen, x,y) = random();
+
+   bool bmi2 = cpu_hasBMI2();
+   fprintf(stderr, "screen: %dx%d pixels, BMI2: %s\n",
+           RES_WIDTH, RES_HEIGHT, (bmi2) ? "yes" : "no");
+   fprintf(stderr, "mode     portable (us)  pext (us)  speedup  render (us)  p50 (us)  p99 (us)\n");
+
+   static const struct { const char *name; rendererPseudoGraphicsMode mode; int height; }
+   modes[] = { { "quadrant", RENDERER_PSEUDOGRAPHICS_MODE_2x2, 2 },
+               { "braille ", RENDERER_PSEUDOGRAPHICS_MODE_2x4, 4 } };
+   for (size_t i = 0; i < ARRAY_SIZE(modes); i++) {
+       double t_scalar = bench(&rendererPseudoGraphics_glyphCells_scalar, modes[i].height);
+       double t_pext   = 0.;
+#if CPU_X86
+       if (bmi2) {
+          memcpy(check, codes, sizeof(codes));
+          t_pext = bench(&rendererPseudoGraphics_glyphCells_bmi2, modes[i].height);
+          if (memcmp(check, codes, sizeof(codes))) {
+             fprintf(stderr, "error: the kernels differ\n");
+             return 1;
+          }
+       }
+#endif
+       rendererStats stats = {0};
+       double t_render = bench_render(modes[i].mode, &stats);
+       double p50 = rendererStats_percentile(&stats, 0.50) / 1e3;
+       double p99 = rendererStats_percentile(&stats, 0.99) / 1e3;
+       if (t_pext > 0.)
+          fprintf(stderr, "%s  %13.1f  %9.1f  %6.2fx  %11.1f  %8.0f  %8.0f\n", modes[i].name,
+                  t_scalar, t_pext, t_scalar / t_pext, t_render, p50, p99);
+       else
+          fprintf(stderr, "%s  %13.1f  %9s  %7s  %11.1f  %8.0f  %8.0f\n", modes[i].name,
+                  t_scalar, "-", "-", t_render, p50, p99);
+   }
+   return 0;
+}
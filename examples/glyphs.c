@@ -29,7 +29,8 @@ static void waitForAKey(void) {
    //       The plan is for konpu to have its own simple input system
    //       to associate with a renderer. (probably covering just basic
    //       keyboard input)
-   if (renderer_getId() == RENDERER_SDL2) {
+   if (renderer_getId() == RENDERER_SDL2 ||
+       rendererFanOut_find(RENDERER_SDL2) >= 0) {
       SDL_Event event;
       while (true) {
          while(SDL_PollEvent(&event)) {
@@ -67,11 +68,6 @@ static void show(const char* msg, uint64_t glyph)
    print_quadrant(screen, 0,10, "PRESS ANY KEY");
 
    // render screen:
-#if RENDERER_PSEUDOGRAPHICS
-   // TODO: we must have this in the PSEUDOGRAPHICS renderer and remove the #ifdef
-   if (renderer_getId() == RENDERER_PSEUDOGRAPHICS)
-      RENDERER_PSEUDOGRAPHICS_TTY_CLEAR();
-#endif
    render();
    quitOnError();
    waitForAKey();
@@ -84,7 +80,11 @@ int main(int argc, char **argv)
 #if RENDERER_SDL2
    if (rendererSDL2_init("Glyphs Operations Demo", 768, 432)) return 1;
 #elif RENDERER_PSEUDOGRAPHICS
-   if (rendererPseudoGraphics_init(RENDERER_PSEUDOGRAPHICS_MODE_2x2)) return 1;
+   // (draw on the terminal, only updating the cells which change)
+   rendererPseudoGraphicsOptions options = { .differential = true,
+                                             .altScreen    = true,
+                                             .synchronized = true };
+   if (rendererPseudoGraphics_initWithOptions(RENDERER_PSEUDOGRAPHICS_MODE_2x2, &options)) return 1;
 #else
 #  error("no suitable renderer")
 #endif
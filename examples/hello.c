@@ -7,23 +7,18 @@
 #include "konpu.h"             // <-- tadaaa!
 
 
-// paint: render the screen and sleep a bit
+// paint: render the screen and keep it for a number of frames
 static void paint(int delay)
 {
-
-#if RENDERER_PSEUDOGRAPHICS
-   // TODO: we must have this in the PSEUDOGRAPHICS renderer and remove the #ifdef
-   if (renderer_getId() == RENDERER_PSEUDOGRAPHICS)
-      RENDERER_PSEUDOGRAPHICS_TTY_CLEAR();
-#endif
    render();
    if (rendererSingleton.error) {
       renderer_drop();
       exit(1);
    }
 
-   // sleep some n * 60th of a seconds
-   sleep_ms(delay * 1000/60);
+   // wait for the end of the frames (at 60 frames per second)
+   for (int i = 0; i < delay; i++)
+      frame_end();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -36,7 +31,7 @@ static void paint(int delay)
 #  define GLYPH_JAN        GLYPH(386C6C6C386CC600) // bold
 
 // we'll wait a bit before rendering a frame:
-#  define DELAY            15 //milliseconds
+#  define DELAY            15 // frames
 
 
 int main(int argc, char **argv)
@@ -46,7 +41,9 @@ int main(int argc, char **argv)
 #if RENDERER_SDL2
    if (rendererSDL2_init("hello, world!", 768, 432)) return 1;
 #elif RENDERER_PSEUDOGRAPHICS
-   if (rendererPseudoGraphics_init(RENDERER_PSEUDOGRAPHICS_MODE_2x4)) return 1;
+   // (draw on the terminal, only updating the cells which change)
+   rendererPseudoGraphicsOptions options = { .differential = true, .synchronized = true };
+   if (rendererPseudoGraphics_initWithOptions(RENDERER_PSEUDOGRAPHICS_MODE_2x4, &options)) return 1;
 #else
 #  error("no suitable renderer")
 #endif
@@ -54,6 +51,9 @@ int main(int argc, char **argv)
    // init randomizer
    random_init(0xCAFE);
 
+   // pace the frames
+   frame_setRate(60);
+
    while(true) {
 
 #if RENDERER_SDL2
@@ -61,7 +61,8 @@ int main(int argc, char **argv)
       //       The plan is for konpu to have its own simple input system
       //       to associate with a renderer. (probably covering just basic
       //       keyboard input)
-      if (renderer_getId() == RENDERER_SDL2) {
+      if (renderer_getId() == RENDERER_SDL2 ||
+          rendererFanOut_find(RENDERER_SDL2) >= 0) {
           SDL_Event event;
           while(SDL_PollEvent(&event)) {
              switch(event.type) {
@@ -13,7 +13,6 @@ int main(int argc, char **argv)
    // a very important message:
    print_quadrant(screen, 0,0, "Hello, World ...");
 
-   // RENDERER_PSEUDOGRAPHICS_TTY_CLEAR();
    render();                   // render the screen
    sleep_ms(2000);             // sleep 2 seconds
 
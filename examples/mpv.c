@@ -5,7 +5,7 @@
 int main(int argc, char **argv)
 {  (void)argc; (void)argv;  // not using argc/arg
 
-   rendererPPM_init(4, 4);
+   rendererY4M_init(12, 4, 4);
    random_init(1234);
 
 #  define FRAMES 300
@@ -10,6 +10,5 @@ exists()  { command -v "$@" > /dev/null; }
 exists 'mpv' || die 'requires mpv media player as a backend'
 ./"$APP" | mpv --title="$APP"            \
                --really-quiet            \
-               --no-correct-pts --fps=12 \
                --loop \
                "$@"  -
@@ -0,0 +1,67 @@
+#include "bitmap.h"
+#include "util.h"
+
+#if CPU_X86
+#   include <immintrin.h>
+#endif
+
+
+//===< bitmap to ARGB8888 >=====================================================
+
+// portable kernel: copy the 8 pixels of each byte
+static void
+bitmap_toARGB_scalar(const argbTable *table,
+                     const unsigned char *bits, int count, uint32_t *pixels)
+{  for (int i = 0; i < count; i++, pixels += GLYPH_WIDTH) {
+       const uint32_t *run = table->pixels[bits[i]];
+       for (int j = 0; j < GLYPH_WIDTH; j++)
+           pixels[j] = run[j];
+   }
+}
+
+#if CPU_X86
+// SSE2 kernel: the 8 pixels of a byte are two 128-bits stores
+__attribute__((target("sse2"))) static void
+bitmap_toARGB_sse2(const argbTable *table,
+                   const unsigned char *bits, int count, uint32_t *pixels)
+{  for (int i = 0; i < count; i++, pixels += GLYPH_WIDTH) {
+       const __m128i *run = (const __m128i *)table->pixels[bits[i]];
+       _mm_storeu_si128((__m128i *)pixels      , _mm_loadu_si128(run));
+       _mm_storeu_si128((__m128i *)pixels + 1  , _mm_loadu_si128(run + 1));
+   }
+}
+
+// AVX2 kernel: the 8 pixels of a byte are one 256-bits store
+__attribute__((target("avx2"))) static void
+bitmap_toARGB_avx2(const argbTable *table,
+                   const unsigned char *bits, int count, uint32_t *pixels)
+{  for (int i = 0; i < count; i++, pixels += GLYPH_WIDTH) {
+       const __m256i *run = (const __m256i *)table->pixels[bits[i]];
+       _mm256_storeu_si256((__m256i *)pixels, _mm256_loadu_si256(run));
+   }
+}
+#endif
+
+// kernel selected by `argbTable_init`
+static void (*bitmap_toARGB_kernel)(const argbTable*, const unsigned char*,
+                                    int, uint32_t*) = &bitmap_toARGB_scalar;
+
+void argbTable_init(argbTable *table, uint32_t fg, uint32_t bg)
+{  assert(table);
+   for (int byte = 0; byte < 256; byte++)
+       for (int i = 0; i < GLYPH_WIDTH; i++)
+           table->pixels[byte][i] = (byte & (0x80 >> i)) ? fg : bg;
+
+#if CPU_X86
+   if (cpu_hasAVX2())        bitmap_toARGB_kernel = &bitmap_toARGB_avx2;
+   else if (cpu_hasSSE2())   bitmap_toARGB_kernel = &bitmap_toARGB_sse2;
+   else
+#endif
+                             bitmap_toARGB_kernel = &bitmap_toARGB_scalar;
+}
+
+void bitmap_toARGB(const argbTable *table,
+                   const unsigned char *bits, int count, uint32_t *pixels)
+{  (*bitmap_toARGB_kernel)(table, bits, count, pixels); }
+
+//===</ bitmap to ARGB8888 >====================================================
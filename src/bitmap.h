@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * @file
+ * A bitmap is the linear (scanline) representation of pixels with one bit per
+ * pixel: each byte holds 8 consecutive pixels of a line, the leftmost pixel
+ * being the most-significant bit. Thus a byte of a bitmap is exactly the same
+ * thing as a glyph line (see `glyph_line`).
+ *
+ * Renderers which output their pixels line by line use bitmaps as their
+ * intermediate format and this file provides the conversion kernels they share.
+ ******************************************************************************/
+#ifndef  KONPU_BITMAP_H
+#define  KONPU_BITMAP_H
+#include "platform.h"
+#include "c.h"
+#include "glyph.h"
+#include "canvas.h"
+
+
+//===< glyphs to bitmap >=======================================================
+
+// write the (GLYPH_HEIGHT) lines of a row of `count` consecutive glyphs into a
+// bitmap. `pitch` is the number of bytes between two lines in the bitmap.
+static inline void
+bitmap_fromGlyphRow(unsigned char *bits, ptrdiff_t pitch,
+                    const uint64_t *glyphs, int count);
+
+// write the (GLYPH_HEIGHT) lines of the glyph row `y` of a canvas into a bitmap
+#define bitmap_fromCanvasRow(bits, pitch, canvas, y) \
+        bitmap_fromGlyphRow((bits), (pitch),         \
+                            canvas_glyphPointer((canvas), 0, (y)), (canvas).width)
+
+//===</ glyphs to bitmap >======================================================
+
+
+
+//===< bitmap to ARGB8888 >=====================================================
+
+// lookup table which maps a byte of a bitmap to its 8 pixels in ARGB8888
+typedef struct argbTable {
+   uint32_t pixels[256][GLYPH_WIDTH];
+} argbTable;
+
+// fill the lookup table with the given colors (for "set" and "unset" pixels)
+// (this also selects the fastest kernel for `bitmap_toARGB` on this cpu)
+void argbTable_init(argbTable *table, uint32_t fg, uint32_t bg);
+
+// expand `count` bytes of a bitmap line into 8*`count` ARGB8888 pixels
+// (the table must have been initialized with `argbTable_init`)
+void bitmap_toARGB(const argbTable *table,
+                   const unsigned char *bits, int count, uint32_t *pixels);
+
+//===</ bitmap to ARGB8888 >====================================================
+
+
+//--- inline implementation ----------------------------------------------------
+
+static inline void
+bitmap_fromGlyphRow(unsigned char *bits, ptrdiff_t pitch,
+                    const uint64_t *glyphs, int count)
+{  for (int x = 0; x < count; x++) {
+       uint64_t glyph = glyphs[x];
+       for (int y = 0; y < GLYPH_HEIGHT; y++)
+           bits[y * pitch + x] = glyph_line(glyph, y);
+   }
+}
+
+#endif //KONPU_BITMAP_H
@@ -1,4 +1,9 @@
 #include "canvas.h"
+#include "util.h"
+
+#if CPU_X86
+#   include <immintrin.h>
+#endif
 
 // TODO/FIXME: __builtin_abs is a gcc/clang builtin
 //             `int abs(int z)` is otherwise from <stdlib.h>
@@ -11,18 +16,316 @@
 #   define abs(x)  __builtin_abs((x))
 #endif
 
-void canvas_line(canvas cvas, int x0, int y0, int x1, int y1)
+//===< fill >===================================================================
+
+// portable kernel: store a glyph in `count` consecutive glyphs
+// (the loop is simple enough for the compiler to vectorize it by itself)
+static void
+canvas_fillRun_scalar(uint64_t *glyphs, int count, uint64_t glyph)
+{  for (int i = 0; i < count; i++)
+       glyphs[i] = glyph;
+}
+
+#if CPU_X86
+// SSE2 kernel: two glyphs per 128-bits store
+__attribute__((target("sse2"))) static void
+canvas_fillRun_sse2(uint64_t *glyphs, int count, uint64_t glyph)
+{  __m128i pattern = _mm_set1_epi64x((long long)glyph);
+   int i = 0;
+   for (; i + 2 <= count; i += 2)
+       _mm_storeu_si128((__m128i *)(glyphs + i), pattern);
+   for (; i < count; i++)
+       glyphs[i] = glyph;
+}
+
+// AVX2 kernel: four glyphs per 256-bits store
+__attribute__((target("avx2"))) static void
+canvas_fillRun_avx2(uint64_t *glyphs, int count, uint64_t glyph)
+{  __m256i pattern = _mm256_set1_epi64x((long long)glyph);
+   int i = 0;
+   for (; i + 8 <= count; i += 8) {
+       _mm256_storeu_si256((__m256i *)(glyphs + i)    , pattern);
+       _mm256_storeu_si256((__m256i *)(glyphs + i + 4), pattern);
+   }
+   for (; i + 4 <= count; i += 4)
+       _mm256_storeu_si256((__m256i *)(glyphs + i), pattern);
+   for (; i < count; i++)
+       glyphs[i] = glyph;
+}
+#endif
+
+static void canvas_fillRun_select(uint64_t *glyphs, int count, uint64_t glyph);
+
+// kernel storing a run of glyphs (selected at its first use)
+static void (*canvas_fillRun)(uint64_t*, int, uint64_t) = &canvas_fillRun_select;
+
+static void
+canvas_fillRun_select(uint64_t *glyphs, int count, uint64_t glyph)
+{
+#if CPU_X86
+   if (cpu_hasAVX2())        canvas_fillRun = &canvas_fillRun_avx2;
+   else if (cpu_hasSSE2())   canvas_fillRun = &canvas_fillRun_sse2;
+   else
+#endif
+                             canvas_fillRun = &canvas_fillRun_scalar;
+   (*canvas_fillRun)(glyphs, count, glyph);
+}
+
+void canvas_fill(canvas cvas, uint64_t glyph)
 {  CANVAS_ASSERT(cvas);
+   if (canvas_isnull(cvas))   return;
+   TRACE_BEGIN("canvas_fill");
 
-   // TODO: the special cases of drawing a vertical or an horizontal line
-   //       could be handled separately and optimized a lot.
-   // if (y0 == y1) { // horizontal line
-   //   ...
-   // } else if (x0 == x1) { // vertical line
-   //   ...
-   // } else {
-   //   bresenham as below ...
+   if (cvas.stride == cvas.width) {
+      // the rows are contiguous: one sweep over the whole grid
+      (*canvas_fillRun)(cvas.glyphs, cvas.width * cvas.height, glyph);
+   } else {
+      // a crop: one run per row
+      for (int y = 0; y < cvas.height; y++)
+          (*canvas_fillRun)(canvas_glyphPointer(cvas, 0,y), cvas.width, glyph);
+   }
+   TRACE_END("canvas_fill");
+}
+
+// mask of the pixels of a glyph in the columns [x0, x1[ (with 0 <= x0 < x1 <= 8)
+static inline uint64_t canvas_columnMask(int x0, int x1)
+{ return (uint64_t)((0xFFu >> x0) & ~(0xFFu >> x1)) * UINT64_C(0x0101010101010101); }
+
+// mask of the pixels of a glyph in the lines [y0, y1[ (with 0 <= y0 < y1 <= 8)
+static inline uint64_t canvas_lineMask(int y0, int y1)
+{ return (UINT64_MAX >> (GLYPH_WIDTH * y0)) &
+         ((y1 < GLYPH_HEIGHT) ? ~(UINT64_MAX >> (GLYPH_WIDTH * y1)) : UINT64_MAX); }
+
+void canvas_fillRect(canvas cvas, rect r, uint64_t glyph)
+{  CANVAS_ASSERT(cvas);
+   // (`rect_clip` lets an empty rectangle through)
+   if (!rect_clip(&r, GLYPH_WIDTH * cvas.width, GLYPH_HEIGHT * cvas.height) ||
+       r.w <= 0 || r.h <= 0)
+      return;
+   TRACE_BEGIN("canvas_fillRect");
+
+   // the first and last glyphs (inclusive) touched by the rectangle
+   int x0 = r.x / GLYPH_WIDTH,   x1 = (r.x + r.w - 1) / GLYPH_WIDTH;
+   int y0 = r.y / GLYPH_HEIGHT,  y1 = (r.y + r.h - 1) / GLYPH_HEIGHT;
+
+   // masks of the pixels in the rectangle for the glyphs on each edge
+   uint64_t left   = canvas_columnMask(r.x % GLYPH_WIDTH, GLYPH_WIDTH);
+   uint64_t right  = canvas_columnMask(0, (r.x + r.w - 1) % GLYPH_WIDTH + 1);
+   uint64_t top    = canvas_lineMask(r.y % GLYPH_HEIGHT, GLYPH_HEIGHT);
+   uint64_t bottom = canvas_lineMask(0, (r.y + r.h - 1) % GLYPH_HEIGHT + 1);
+   if (x0 == x1)   left = right  = left & right;
+   if (y0 == y1)   top  = bottom = top  & bottom;
+
+   int inner = x1 - x0 - 1; // number of glyphs between the left and right ones
+   for (int y = y0; y <= y1; y++) {
+       uint64_t lines = (y == y0) ? top : (y == y1) ? bottom : UINT64_MAX;
+       uint64_t *row  = canvas_glyphPointer(cvas, x0,y);
 
+       row[0] = UINT_MERGE(row[0], glyph, lines & left);
+       if (x0 == x1)   continue;
+       if (lines == UINT64_MAX) {
+          if (inner > 0)   (*canvas_fillRun)(row + 1, inner, glyph);
+       } else {
+          for (int x = 1; x <= inner; x++)
+              row[x] = UINT_MERGE(row[x], glyph, lines);
+       }
+       row[inner + 1] = UINT_MERGE(row[inner + 1], glyph, lines & right);
+   }
+   TRACE_END("canvas_fillRect");
+}
+
+//===</ fill >==================================================================
+
+
+//===< lines >==================================================================
+
+// set the pixels [x0, x1] of the pixel line y (which must be on the canvas)
+// with one store per glyph (ie: up to 8 pixels at once)
+static inline void
+canvas_hspan(canvas cvas, int x0, int x1, int y)
+{  uint64_t *glyph = canvas_glyphPointerFromPixel(cvas, x0, y);
+   int      shift  = GLYPH_WIDTH * (GLYPH_HEIGHT - 1 - y % GLYPH_HEIGHT);
+   unsigned left   = 0xFFu >> (x0 % GLYPH_WIDTH);
+   unsigned right  = (0xFFu << (GLYPH_WIDTH - 1 - x1 % GLYPH_WIDTH)) & 0xFFu;
+   int      n      = x1 / GLYPH_WIDTH - x0 / GLYPH_WIDTH;
+   if (n == 0) {
+      glyph[0] |= (uint64_t)(left & right) << shift;
+      return;
+   }
+   glyph[0] |= (uint64_t)left << shift;
+   for (int i = 1; i < n; i++)
+       glyph[i] |= UINT64_C(0xFF) << shift;
+   glyph[n] |= (uint64_t)right << shift;
+}
+
+// set the pixels [y0, y1] of the pixel column x (which must be on the canvas)
+// with one store per glyph (ie: up to 8 pixels at once)
+static inline void
+canvas_vspan(canvas cvas, int x, int y0, int y1)
+{  uint64_t column = canvas_columnMask(x % GLYPH_WIDTH, x % GLYPH_WIDTH + 1);
+   int      gx     = x  / GLYPH_WIDTH;
+   int      gy0    = y0 / GLYPH_HEIGHT,  gy1 = y1 / GLYPH_HEIGHT;
+   uint64_t top    = canvas_lineMask(y0 % GLYPH_HEIGHT, GLYPH_HEIGHT);
+   uint64_t bottom = canvas_lineMask(0, y1 % GLYPH_HEIGHT + 1);
+   if (gy0 == gy1) {
+      canvas_glyph(cvas, gx, gy0) |= column & top & bottom;
+      return;
+   }
+   canvas_glyph(cvas, gx, gy0) |= column & top;
+   for (int gy = gy0 + 1; gy < gy1; gy++)
+       canvas_glyph(cvas, gx, gy) |= column;
+   canvas_glyph(cvas, gx, gy1) |= column & bottom;
+}
+
+void canvas_hline(canvas cvas, int x0, int x1, int y)
+{  CANVAS_ASSERT(cvas);
+   if (x0 > x1)   UTIL_SWAP(x0, x1);
+   if (y < 0 || y >= GLYPH_HEIGHT * cvas.height ||
+       x1 < 0 || x0 >= GLYPH_WIDTH * cvas.width)
+      return;
+   if (x0 < 0)                          x0 = 0;
+   if (x1 >= GLYPH_WIDTH * cvas.width)  x1 = GLYPH_WIDTH * cvas.width - 1;
+   canvas_hspan(cvas, x0, x1, y);
+}
+
+void canvas_vline(canvas cvas, int x, int y0, int y1)
+{  CANVAS_ASSERT(cvas);
+   if (y0 > y1)   UTIL_SWAP(y0, y1);
+   if (x < 0 || x >= GLYPH_WIDTH * cvas.width ||
+       y1 < 0 || y0 >= GLYPH_HEIGHT * cvas.height)
+      return;
+   if (y0 < 0)                           y0 = 0;
+   if (y1 >= GLYPH_HEIGHT * cvas.height) y1 = GLYPH_HEIGHT * cvas.height - 1;
+   canvas_vspan(cvas, x, y0, y1);
+}
+
+// Clipping a line with the exact pixels of the Bresenham's loop
+// -------------------------------------------------------------
+//
+// Along the major axis of a line (x for a shallow line (dx > dy), else y),
+// its pixel k (0 <= k <= dmaj) is at k steps from the start, and along the
+// minor axis, it's at `steps(k)` steps, as the Bresenham's loop keeps its error
+// term as h - k * dmin + steps(k) * dmaj in [0, dmaj[ (with h = dmaj/2 being
+// its initial value, and for steep lines, the error term is -err), ie:
+//    steps(k) = ceil((k * dmin - h) / dmaj)
+//
+// As `steps` is monotonic, the visible pixels are a range of k, which gives
+// the ends of the clipped line and the error term at its first pixel. And:
+//    steps(k) >= m  <=>  k >  floor(((m - 1) * dmaj + h) / dmin)
+//    steps(k) <= m  <=>  k <= floor((m * dmaj + h) / dmin)
+// (the products are done on 64 bits)
+
+// floor of a / b (with b > 0)
+static inline int64_t canvas_floorDiv(int64_t a, int64_t b)
+{ return a / b - (a % b < 0); }
+
+// steps(k) of a line along its minor axis (see above)
+static inline int canvas_lineSteps(int64_t k, int dmaj, int dmin)
+{ return (int)canvas_floorDiv(k * dmin - dmaj / 2 + dmaj - 1, dmaj); }
+
+// range of steps j such that (c + s * j) is in [0, size[
+static inline void
+canvas_lineRange(int c, int s, int size, int64_t *lo, int64_t *hi)
+{  *lo = (s > 0) ? -(int64_t)c : (int64_t)c - size + 1;
+   *hi = *lo + size - 1;
+}
+
+// clip a line along its major axis (maj0, smaj) and its minor axis (min0, smin)
+// to the canvas dimensions (in pixels) on those axes: set [*k0, *k1] as the
+// range of visible pixels, or return false if the line isn't visible.
+static bool
+canvas_lineClip(int maj0, int smaj, int dmaj, int size_maj,
+                int min0, int smin, int dmin, int size_min, int *k0, int *k1)
+{  int64_t lo, hi, mlo, mhi, h = dmaj / 2;
+   canvas_lineRange(maj0, smaj, size_maj, &lo, &hi);
+   canvas_lineRange(min0, smin, size_min, &mlo, &mhi);
+   if (lo < 0)      lo = 0;
+   if (hi > dmaj)   hi = dmaj;
+   if (mlo > 0) {
+      int64_t k = canvas_floorDiv((mlo - 1) * dmaj + h, dmin) + 1;
+      if (lo < k)   lo = k;
+   }
+   int64_t k = canvas_floorDiv(mhi * dmaj + h, dmin);
+   if (hi > k)   hi = k;
+   if (lo > hi)
+      return false;
+   *k0 = (int)lo;
+   *k1 = (int)hi;
+   return true;
+}
+
+// draw the visible line (x0,y0)-(x1,y1) by runs (see `canvas_line`), with
+// the directions (sx,sy) and dimensions (dx,dy) of the line before clipping,
+// and `err` being the error term of the Bresenham's loop at the first pixel
+static inline void
+canvas_lineRuns(canvas cvas, int x0, int y0, int x1, int y1,
+                int dx, int dy, int sx, int sy, int err)
+{
+   if (dx > dy) {
+      int q = dx / dy, r = dx % dy;
+      int run = err / dy;               // pixels after the first one of the run
+      int rem = err % dy;
+      for (;;) {
+          int left = (x1 - x0) * sx;    // pixels left after x0
+          if (run > left)   run = left;
+          int x = x0 + run * sx;
+          if (sx > 0)   canvas_hspan(cvas, x0, x, y0);
+          else          canvas_hspan(cvas, x, x0, y0);
+          if (run == left)   break;
+          x0   = x + sx;
+          y0  += sy;
+          // next `err` is rem + dx - dy, ie: rem + r + (q-1) * dy
+          run  = q - 1;
+          rem += r;
+          if (rem >= dy) { rem -= dy; run++; }
+      }
+   } else {
+      int q = dy / dx, r = dy % dx;
+      int run = -err / dx;
+      int rem = -err % dx;
+      for (;;) {
+          int left = (y1 - y0) * sy;
+          if (run > left)   run = left;
+          int y = y0 + run * sy;
+          if (sy > 0)   canvas_vspan(cvas, x0, y0, y);
+          else          canvas_vspan(cvas, x0, y, y0);
+          if (run == left)   break;
+          y0   = y + sy;
+          x0  += sx;
+          run  = q - 1;
+          rem += r;
+          if (rem >= dx) { rem -= dx; run++; }
+      }
+   }
+}
+
+// draw the visible line pixel by pixel (with the same arguments as above)
+static inline void
+canvas_linePixels(canvas cvas, int x0, int y0, int x1, int y1,
+                  int dx, int dy, int sx, int sy, int err)
+{  int e2;
+   for(;;) {
+      canvas_setPixel(cvas, x0, y0);
+      if (x0 == x1 && y0 == y1) break;
+      e2 = err;
+      if (e2 >-dx) { err -= dy; x0 += sx; }
+      if (e2 < dy) { err += dx; y0 += sy; }
+   }
+}
+
+void canvas_line(canvas cvas, int x0, int y0, int x1, int y1)
+{  CANVAS_ASSERT(cvas);
+   TRACE_BEGIN("canvas_line");
+
+   // axis-aligned lines are a single span
+   if (y0 == y1) {
+      canvas_hline(cvas, x0, x1, y0);
+      goto end;
+   }
+   if (x0 == x1) {
+      canvas_vline(cvas, x0, y0, y1);
+      goto end;
+   }
 
    // This is the classic Bresenham's Algorithm which draws straight lines
    // using only simple integer arithmetic.
@@ -32,24 +335,342 @@ void canvas_line(canvas cvas, int x0, int y0, int x1, int y1)
    // based on: https://rosettacode.org/wiki/Bitmap/Bresenham's_line_algorithm#C
    //           Content in Rosetta code is (CC BY-SA 4.0)
    //           https://creativecommons.org/licenses/by-sa/4.0/
+   // (see `canvas_linePixels`)
+   int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+   int dy = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
 
-   int dx  = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-   int dy  = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-   int err = (dx>dy ? dx : -dy)/2, e2;
+   // First, the line is clipped to the canvas (see above), so that only its
+   // visible pixels are stepped through, and without bounds checks.
+   int k0, k1, m0, m1, err;
+   if (dx > dy) {
+      if (!canvas_lineClip(x0, sx, dx, GLYPH_WIDTH  * cvas.width,
+                           y0, sy, dy, GLYPH_HEIGHT * cvas.height, &k0, &k1))
+         goto end;
+      m0  = canvas_lineSteps(k0, dx, dy);
+      m1  = canvas_lineSteps(k1, dx, dy);
+      err = (int)(dx / 2 - (int64_t)k0 * dy + (int64_t)m0 * dx);
+      x1  = x0 + sx * k1;   y1 = y0 + sy * m1;
+      x0 += sx * k0;        y0 += sy * m0;
+   } else {
+      if (!canvas_lineClip(y0, sy, dy, GLYPH_HEIGHT * cvas.height,
+                           x0, sx, dx, GLYPH_WIDTH  * cvas.width, &k0, &k1))
+         goto end;
+      m0  = canvas_lineSteps(k0, dy, dx);
+      m1  = canvas_lineSteps(k1, dy, dx);
+      err = (int)-(dy / 2 - (int64_t)k0 * dx + (int64_t)m0 * dy);
+      y1  = y0 + sy * k1;   x1 = x0 + sx * m1;
+      y0 += sy * k0;        x0 += sx * m0;
+   }
 
-   for(;;) {
+   // Then, unless the line is close to a diagonal, it's drawn by runs (ie: a
+   // "run-sliced" Bresenham) with the same pixels: a shallow line (dx > dy)
+   // always steps along x, and steps along y only once `err` falls below dy,
+   // so the run of pixels on a same pixel line has (err / dy) + 1 pixels, and
+   // after the first run, that's (dx / dy) or (dx / dy) + 1 pixels. And
+   // likewise for steep lines with -err and dx. Close to a diagonal, the runs
+   // are too short (less than 2 pixels on average) to be worth it.
+   if (dx >= 2 * dy || dy >= 2 * dx)
+      canvas_lineRuns(cvas, x0, y0, x1, y1, dx, dy, sx, sy, err);
+   else
+      canvas_linePixels(cvas, x0, y0, x1, y1, dx, dy, sx, sy, err);
+end:
+   TRACE_END("canvas_line");
+}
 
-      // setPixel(x0,y0)
-      if (x0 >= 0  &&  x0 < GLYPH_WIDTH  * cvas.width  &&
-          y0 >= 0  &&  y0 < GLYPH_HEIGHT * cvas.height) {
-         // TODO: after implementing canvas_pixel* macros/inline funcs
-         //       remove this ugly expression
-         canvas_glyph(cvas, x0 / 8, y0 / 8) |= glyph_fromPixel(x0 % 8, y0 % 8);
-      }
+//===</ lines >=================================================================
 
-      if (x0 == x1 && y0 == y1) break;
-      e2 = err;
-      if (e2 >-dx) { err -= dy; x0 += sx; }
-      if (e2 < dy) { err += dx; y0 += sy; }
+
+
+//===< blit >===================================================================
+
+// glyph (x,y) of the source, or 0 if it's out of the source
+static inline uint64_t canvas_blitGlyph(const_canvas src, int x, int y)
+{ return (x >= 0 && x < src.width && y >= 0 && y < src.height) ?
+         canvas_glyph(src, x,y) : 0; }
+
+// the lines [oy, 8[ of the glyph `top` followed by the lines [0, oy[ of the
+// glyph `bottom` (ie: a glyph from the pixels of two glyphs on top of another)
+static inline uint64_t canvas_funnelV(uint64_t top, uint64_t bottom, int oy)
+{ return (oy == 0) ? top : (top    << (GLYPH_WIDTH * oy)) |
+                           (bottom >> (GLYPH_WIDTH * (GLYPH_HEIGHT - oy))); }
+
+// the columns [ox, 8[ of the glyph `left` followed by the columns [0, ox[ of
+// the glyph `right` (ie: a glyph from the pixels of two glyphs side by side)
+static inline uint64_t canvas_funnelH(uint64_t left, uint64_t right, int ox)
+{  if (ox == 0)   return left;
+   uint64_t keep = canvas_columnMask(0, GLYPH_WIDTH - ox);
+   return ((left << ox) & keep) | ((right >> (GLYPH_WIDTH - ox)) & ~keep);
+}
+
+// clip a blit: set `r` as the rectangle of the source and (*x,*y) as its
+// position in the destination, so that both are visible, or return false
+static bool
+canvas_blitClip(canvas dst, int *x, int *y, const_canvas src, rect *r)
+{  rect_normalize(r);
+   int x0 = r->x, y0 = r->y;
+   if (!rect_clip(r, GLYPH_WIDTH * src.width, GLYPH_HEIGHT * src.height) ||
+       r->w <= 0 || r->h <= 0)
+      return false;
+   *x += r->x - x0;
+   *y += r->y - y0;
+
+   rect d = { .x = *x, .y = *y, .w = r->w, .h = r->h };
+   if (!rect_clip(&d, GLYPH_WIDTH * dst.width, GLYPH_HEIGHT * dst.height) ||
+       d.w <= 0 || d.h <= 0)
+      return false;
+   r->x += d.x - *x;   r->w = d.w;
+   r->y += d.y - *y;   r->h = d.h;
+   *x = d.x;
+   *y = d.y;
+   return true;
+}
+
+// blit engine: the (visible) rectangle `r` of the destination takes the pixels
+// of the source at an offset of (offx,offy) pixels, combined with `rop`, and
+// only where the pixels of the mask are set (if there's a mask)
+static inline void
+canvas_blitRop(canvas dst, rect r, const_canvas src, const_canvas *mask,
+               int offx, int offy, canvasRop rop)
+{
+   // the first and last glyphs (inclusive) of the destination
+   int x0 = r.x / GLYPH_WIDTH,   x1 = (r.x + r.w - 1) / GLYPH_WIDTH;
+   int y0 = r.y / GLYPH_HEIGHT,  y1 = (r.y + r.h - 1) / GLYPH_HEIGHT;
+
+   // masks of the pixels in the rectangle for the glyphs on each edge
+   uint64_t left   = canvas_columnMask(r.x % GLYPH_WIDTH, GLYPH_WIDTH);
+   uint64_t right  = canvas_columnMask(0, (r.x + r.w - 1) % GLYPH_WIDTH + 1);
+   uint64_t top    = canvas_lineMask(r.y % GLYPH_HEIGHT, GLYPH_HEIGHT);
+   uint64_t bottom = canvas_lineMask(0, (r.y + r.h - 1) % GLYPH_HEIGHT + 1);
+
+   // the glyph (gx,gy) of the destination takes the pixels of the source from
+   // the glyphs (gx+bx, gy+by) to (gx+bx+1, gy+by+1), shifted by (ox,oy)
+   int ox = (offx % GLYPH_WIDTH  + GLYPH_WIDTH)  % GLYPH_WIDTH;
+   int oy = (offy % GLYPH_HEIGHT + GLYPH_HEIGHT) % GLYPH_HEIGHT;
+   int bx = (offx - ox) / GLYPH_WIDTH;
+   int by = (offy - oy) / GLYPH_HEIGHT;
+
+   for (int gy = y0; gy <= y1; gy++) {
+       uint64_t lines = UINT64_MAX;
+       if (gy == y0)   lines &= top;
+       if (gy == y1)   lines &= bottom;
+
+       // (each column of two source glyphs is funneled once, then shared by
+       //  two neighbouring glyphs of the destination)
+       int sx = x0 + bx, sy = gy + by;
+       uint64_t s0 = canvas_funnelV(canvas_blitGlyph(src, sx, sy),
+                                    canvas_blitGlyph(src, sx, sy + 1), oy);
+       uint64_t m0 = (mask) ? canvas_funnelV(canvas_blitGlyph(*mask, sx, sy),
+                                             canvas_blitGlyph(*mask, sx, sy + 1), oy)
+                            : 0;
+       uint64_t *glyph = canvas_glyphPointer(dst, x0, gy);
+       for (int gx = x0; gx <= x1; gx++, glyph++) {
+           sx++;
+           uint64_t s1 = canvas_funnelV(canvas_blitGlyph(src, sx, sy),
+                                        canvas_blitGlyph(src, sx, sy + 1), oy);
+           uint64_t s  = canvas_funnelH(s0, s1, ox);
+           s0 = s1;
+
+           uint64_t m = lines;
+           if (gx == x0)   m &= left;
+           if (gx == x1)   m &= right;
+           if (mask) {
+              uint64_t m1 = canvas_funnelV(canvas_blitGlyph(*mask, sx, sy),
+                                           canvas_blitGlyph(*mask, sx, sy + 1), oy);
+              m &= canvas_funnelH(m0, m1, ox);
+              m0 = m1;
+           }
+
+           switch (rop) {
+              case CANVAS_ROP_COPY:    *glyph  = UINT_MERGE(*glyph, s, m); break;
+              case CANVAS_ROP_OR:      *glyph |=  (s & m);                 break;
+              case CANVAS_ROP_AND:     *glyph &=  (s | ~m);                break;
+              case CANVAS_ROP_XOR:     *glyph ^=  (s & m);                 break;
+              case CANVAS_ROP_ANDNOT:  *glyph &= ~(s & m);                 break;
+           }
+       }
+   }
+}
+
+void canvas_blit(canvas dst, int x, int y, const_canvas src, rect src_rect, canvasRop rop)
+{  CANVAS_ASSERT(dst);
+   CANVAS_ASSERT(src);
+   if (!canvas_blitClip(dst, &x, &y, src, &src_rect))
+      return;
+   TRACE_BEGIN("canvas_blit");
+
+   // (one specialized engine per raster operation)
+   rect r    = { .x = x, .y = y, .w = src_rect.w, .h = src_rect.h };
+   int  offx = src_rect.x - x;
+   int  offy = src_rect.y - y;
+   switch (rop) {
+      case CANVAS_ROP_COPY:   canvas_blitRop(dst, r, src, NULL, offx, offy, CANVAS_ROP_COPY);   break;
+      case CANVAS_ROP_OR:     canvas_blitRop(dst, r, src, NULL, offx, offy, CANVAS_ROP_OR);     break;
+      case CANVAS_ROP_AND:    canvas_blitRop(dst, r, src, NULL, offx, offy, CANVAS_ROP_AND);    break;
+      case CANVAS_ROP_XOR:    canvas_blitRop(dst, r, src, NULL, offx, offy, CANVAS_ROP_XOR);    break;
+      case CANVAS_ROP_ANDNOT: canvas_blitRop(dst, r, src, NULL, offx, offy, CANVAS_ROP_ANDNOT); break;
+   }
+   TRACE_END("canvas_blit");
+}
+
+void canvas_blitMerge(canvas dst, int x, int y, const_canvas src, const_canvas mask, rect src_rect)
+{  CANVAS_ASSERT(dst);
+   CANVAS_ASSERT(src);
+   CANVAS_ASSERT(mask);
+   if (!canvas_blitClip(dst, &x, &y, src, &src_rect))
+      return;
+   TRACE_BEGIN("canvas_blitMerge");
+
+   // (merging is copying where the mask is set)
+   rect r = { .x = x, .y = y, .w = src_rect.w, .h = src_rect.h };
+   canvas_blitRop(dst, r, src, &mask, src_rect.x - x, src_rect.y - y, CANVAS_ROP_COPY);
+   TRACE_END("canvas_blitMerge");
+}
+
+//===</ blit >==================================================================
+
+
+
+//===< bulk raster operations >=================================================
+
+// operations of the bulk raster operations
+typedef enum canvasOp {
+   CANVAS_OP_AND, CANVAS_OP_OR, CANVAS_OP_XOR, CANVAS_OP_ANDNOT, CANVAS_OP_NOT,
+   CANVAS_OP_MERGE,
+} canvasOp;
+
+// portable kernel: an operation on `count` consecutive glyphs
+// (the loops are simple enough for the compiler to vectorize them by itself)
+static void
+canvas_opRun_scalar(canvasOp op, uint64_t *dst, const uint64_t *a,
+                    const uint64_t *b, const uint64_t *mask, int count)
+{  switch (op) {
+      case CANVAS_OP_AND:    for (int i = 0; i < count; i++) dst[i] = a[i] &  b[i];  break;
+      case CANVAS_OP_OR:     for (int i = 0; i < count; i++) dst[i] = a[i] |  b[i];  break;
+      case CANVAS_OP_XOR:    for (int i = 0; i < count; i++) dst[i] = a[i] ^  b[i];  break;
+      case CANVAS_OP_ANDNOT: for (int i = 0; i < count; i++) dst[i] = a[i] & ~b[i];  break;
+      case CANVAS_OP_NOT:    for (int i = 0; i < count; i++) dst[i] = ~a[i];         break;
+      case CANVAS_OP_MERGE:  for (int i = 0; i < count; i++)
+                                 dst[i] = UINT_MERGE(a[i], b[i], mask[i]);
+                             break;
    }
 }
+
+#if CPU_X86
+// SSE2 kernel: two glyphs per 128-bits operation
+__attribute__((target("sse2"))) static void
+canvas_opRun_sse2(canvasOp op, uint64_t *dst, const uint64_t *a,
+                  const uint64_t *b, const uint64_t *mask, int count)
+{
+#  define LOAD(p)      _mm_loadu_si128((const __m128i *)((p) + i))
+#  define STORE(v)     _mm_storeu_si128((__m128i *)(dst + i), (v))
+#  define LOOP(expr)   for (; i + 2 <= count; i += 2) STORE(expr); break
+   int i = 0;
+   __m128i ones = _mm_set1_epi32(-1);
+   switch (op) {
+      case CANVAS_OP_AND:    LOOP(_mm_and_si128(LOAD(a), LOAD(b)));
+      case CANVAS_OP_OR:     LOOP(_mm_or_si128(LOAD(a), LOAD(b)));
+      case CANVAS_OP_XOR:    LOOP(_mm_xor_si128(LOAD(a), LOAD(b)));
+      case CANVAS_OP_ANDNOT: LOOP(_mm_andnot_si128(LOAD(b), LOAD(a)));
+      case CANVAS_OP_NOT:    LOOP(_mm_xor_si128(LOAD(a), ones));
+      case CANVAS_OP_MERGE:  LOOP(_mm_or_si128(_mm_andnot_si128(LOAD(mask), LOAD(a)),
+                                               _mm_and_si128(LOAD(mask), LOAD(b))));
+   }
+#  undef LOAD
+#  undef STORE
+#  undef LOOP
+   canvas_opRun_scalar(op, dst + i, a + i, b + i, mask + i, count - i);
+}
+
+// AVX2 kernel: four glyphs per 256-bits operation
+__attribute__((target("avx2"))) static void
+canvas_opRun_avx2(canvasOp op, uint64_t *dst, const uint64_t *a,
+                  const uint64_t *b, const uint64_t *mask, int count)
+{
+#  define LOAD(p)      _mm256_loadu_si256((const __m256i *)((p) + i))
+#  define STORE(v)     _mm256_storeu_si256((__m256i *)(dst + i), (v))
+#  define LOOP(expr)   for (; i + 4 <= count; i += 4) STORE(expr); break
+   int i = 0;
+   __m256i ones = _mm256_set1_epi32(-1);
+   switch (op) {
+      case CANVAS_OP_AND:    LOOP(_mm256_and_si256(LOAD(a), LOAD(b)));
+      case CANVAS_OP_OR:     LOOP(_mm256_or_si256(LOAD(a), LOAD(b)));
+      case CANVAS_OP_XOR:    LOOP(_mm256_xor_si256(LOAD(a), LOAD(b)));
+      case CANVAS_OP_ANDNOT: LOOP(_mm256_andnot_si256(LOAD(b), LOAD(a)));
+      case CANVAS_OP_NOT:    LOOP(_mm256_xor_si256(LOAD(a), ones));
+      case CANVAS_OP_MERGE:  LOOP(_mm256_or_si256(_mm256_andnot_si256(LOAD(mask), LOAD(a)),
+                                                  _mm256_and_si256(LOAD(mask), LOAD(b))));
+   }
+#  undef LOAD
+#  undef STORE
+#  undef LOOP
+   canvas_opRun_scalar(op, dst + i, a + i, b + i, mask + i, count - i);
+}
+#endif
+
+static void canvas_opRun_select(canvasOp op, uint64_t *dst, const uint64_t *a,
+                                const uint64_t *b, const uint64_t *mask, int count);
+
+// kernel doing an operation on a run of glyphs (selected at its first use)
+static void (*canvas_opRun)(canvasOp, uint64_t*, const uint64_t*, const uint64_t*,
+                            const uint64_t*, int) = &canvas_opRun_select;
+
+static void
+canvas_opRun_select(canvasOp op, uint64_t *dst, const uint64_t *a,
+                    const uint64_t *b, const uint64_t *mask, int count)
+{
+#if CPU_X86
+   if (cpu_hasAVX2())        canvas_opRun = &canvas_opRun_avx2;
+   else if (cpu_hasSSE2())   canvas_opRun = &canvas_opRun_sse2;
+   else
+#endif
+                             canvas_opRun = &canvas_opRun_scalar;
+   (*canvas_opRun)(op, dst, a, b, mask, count);
+}
+
+static inline int canvas_min(int x, int y)   { return (x < y) ? x : y; }
+
+// do an operation on the canvases (the unused operands are `a`)
+static void
+canvas_op(canvasOp op, canvas dst, const_canvas a, const_canvas b, const_canvas mask)
+{  CANVAS_ASSERT(dst);
+   CANVAS_ASSERT(a);
+   CANVAS_ASSERT(b);
+   CANVAS_ASSERT(mask);
+   int width  = canvas_min(canvas_min(dst.width,  a.width),  canvas_min(b.width,  mask.width));
+   int height = canvas_min(canvas_min(dst.height, a.height), canvas_min(b.height, mask.height));
+   if (width <= 0 || height <= 0)
+      return;
+   TRACE_BEGIN("canvas_op");
+
+   if (dst.stride == width && a.stride == width &&
+       b.stride   == width && mask.stride == width) {
+      // the rows are contiguous: one run over the whole grids
+      (*canvas_opRun)(op, dst.glyphs, a.glyphs, b.glyphs, mask.glyphs, width * height);
+   } else {
+      // crops: one run per row
+      for (int y = 0; y < height; y++)
+          (*canvas_opRun)(op, canvas_glyphPointer(dst, 0,y), canvas_glyphPointer(a, 0,y),
+                          canvas_glyphPointer(b, 0,y), canvas_glyphPointer(mask, 0,y), width);
+   }
+   TRACE_END("canvas_op");
+}
+
+void canvas_and(canvas dst, const_canvas a, const_canvas b)
+{ canvas_op(CANVAS_OP_AND, dst, a, b, a); }
+
+void canvas_or(canvas dst, const_canvas a, const_canvas b)
+{ canvas_op(CANVAS_OP_OR, dst, a, b, a); }
+
+void canvas_xor(canvas dst, const_canvas a, const_canvas b)
+{ canvas_op(CANVAS_OP_XOR, dst, a, b, a); }
+
+void canvas_andnot(canvas dst, const_canvas a, const_canvas b)
+{ canvas_op(CANVAS_OP_ANDNOT, dst, a, b, a); }
+
+void canvas_not(canvas dst, const_canvas a)
+{ canvas_op(CANVAS_OP_NOT, dst, a, a, a); }
+
+void canvas_merge(canvas dst, const_canvas a, const_canvas b, const_canvas mask)
+{ canvas_op(CANVAS_OP_MERGE, dst, a, b, mask); }
+
+//===</ bulk raster operations >================================================
@@ -3,6 +3,7 @@
 #include "platform.h"
 #include "glyph.h"
 #include "rect.h"
+#include "trace.h"
 
 //===< CANVAS >=================================================================
 
@@ -178,17 +179,70 @@ canvas_crop(canvas cvas, rect crop_area)
 ////////////////////////////////////////////////////////////////////////////////
 
 // fill the canvas' grid with one glyph
-static inline void
-canvas_set(canvas cvas, uint64_t glyph)
-{  CANVAS_ASSERT(cvas);
-   for (int y = 0; y < cvas.height; y++)
-       for (int x = 0; x < cvas.width; x++)
-           canvas_glyph(cvas, x,y) = glyph;
-}
+// (the rows of the canvas are swept as one contiguous run of glyphs when the
+//  canvas isn't a crop, and the stores are vectorized when the cpu allows it)
+void canvas_fill(canvas cvas, uint64_t glyph);
+
+// same as `canvas_fill`
+static inline void canvas_set(canvas cvas, uint64_t glyph)
+{ canvas_fill(cvas, glyph); }
+
+// fill a rectangle of pixels (given in pixel coordinates, and clipped to the
+// canvas) with the pixels of a glyph used as a pattern, ie: each pixel of the
+// rectangle takes the value of the pixel at the same position in the glyph.
+// (for example, a glyph of 0 clears the pixels, and a glyph of ~0 sets them)
+// The edges don't need to be glyph-aligned: each glyph touched by the
+// rectangle is written with one masked store.
+void canvas_fillRect(canvas cvas, rect r, uint64_t glyph);
 
 
 // draw a line on the given canvas between the points (x0,y0) and (x1,y1)
+// (it's drawn by horizontal or vertical runs of pixels, see below)
 void canvas_line(canvas cvas, int x0, int y0, int x1, int y1);
 
+// draw an horizontal line between the points (x0,y) and (x1,y), or a vertical
+// line between the points (x,y0) and (x,y1). Those set up to 8 pixels at once.
+void canvas_hline(canvas cvas, int x0, int x1, int y);
+void canvas_vline(canvas cvas, int x, int y0, int y1);
+
+
+// raster operations of `canvas_blit`, ie: how a pixel of the destination (d)
+// is combined with the pixel of the source (s)
+typedef enum canvasRop {
+   CANVAS_ROP_COPY,    // d = s
+   CANVAS_ROP_OR,      // d = d | s
+   CANVAS_ROP_AND,     // d = d & s
+   CANVAS_ROP_XOR,     // d = d ^ s
+   CANVAS_ROP_ANDNOT,  // d = d & ~s
+} canvasRop;
+
+// combine the pixels of a rectangle of a source canvas (given in pixel
+// coordinates) to a destination canvas, with its upper-left corner at pixel
+// (x,y) of the destination, and with a raster operation.
+// The positions don't need to be glyph-aligned: the glyphs of the source are
+// shifted into place 64 bits at a time. Both rectangles are clipped to their
+// canvas. The source and destination shouldn't overlap in memory.
+void canvas_blit(canvas dst, int x, int y, const_canvas src, rect src_rect, canvasRop rop);
+
+// same as `canvas_blit`, but each pixel of the destination takes the pixel of
+// the source only where the pixel of the mask (a canvas with the same pixel
+// coordinates as the source, eg: the mask of a sprite) is set, ie: the MERGE
+// raster operation, d = (m) ? s : d
+void canvas_blitMerge(canvas dst, int x, int y, const_canvas src, const_canvas mask, rect src_rect);
+
+
+// glyph by glyph raster operations between canvases of the same dimensions
+// (else, only their upper-left area in common is processed). The destination
+// may be one of the operands (but may not overlap them otherwise).
+// The rows are processed as one contiguous run of glyphs when none of the
+// canvases is a crop, and vectorized when the cpu allows it.
+void canvas_and   (canvas dst, const_canvas a, const_canvas b);  // dst = a & b
+void canvas_or    (canvas dst, const_canvas a, const_canvas b);  // dst = a | b
+void canvas_xor   (canvas dst, const_canvas a, const_canvas b);  // dst = a ^ b
+void canvas_andnot(canvas dst, const_canvas a, const_canvas b);  // dst = a & ~b
+void canvas_not   (canvas dst, const_canvas a);                  // dst = ~a
+// dst = the pixels of b where the pixels of mask are set, else those of a
+void canvas_merge (canvas dst, const_canvas a, const_canvas b, const_canvas mask);
+
 
 #endif //KONPU_CANVAS_H
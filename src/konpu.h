@@ -8,6 +8,8 @@
 // utilities
 #include "bits.h"
 #include "util.h"
+#include "thread.h"
+#include "trace.h"
 
 // graphics
 #include "glyph.h"
@@ -16,12 +18,16 @@
 #include "screen.h"
 #include "font.h"
 #include "print.h"
+#include "bitmap.h"
 
 //===< renderers >==============================================================
 #include "renderer.h"
+#include "output.h"
 #include "renderer_SDL2.h"
 #include "renderer_ppm.h"
+#include "renderer_y4m.h"
 #include "renderer_pseudographics.h"
+#include "renderer_fanout.h"
 
 /// @brief Konpu tries to initialize a renderer with sensible defaults
 /// @return 0 iff success
@@ -46,13 +52,19 @@ static inline int renderer_initSimple()
 //===< includes the implementation >============================================
 #ifdef   KONPU_IMPLEMENTATION
 #   include "util.c"
+#   include "thread.c"
+#   include "trace.c"
+#   include "bitmap.c"
 #   include "canvas.c"
 #   include "screen.c"
 #   include "font.c"
 #   include "print.c"
 #   include "renderer.c"
+#   include "output.c"
 #   include "renderer_SDL2.c"
 #   include "renderer_ppm.c"
+#   include "renderer_y4m.c"
 #   include "renderer_pseudographics.c"
+#   include "renderer_fanout.c"
 #endif //KONPU_IMPLEMENTATION
 //===</ includes the implementation >===========================================
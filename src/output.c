@@ -0,0 +1,460 @@
+#include "output.h"
+#if KONPU_PLATFORM_LIBC
+#include "util.h"
+#include "renderer.h"
+#include <stdlib.h>
+#include <string.h>
+#if OUTPUT_VECTORED
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+    // (<stdio.h> only declares this one with a POSIX feature macro)
+    int fileno(FILE *stream);
+#   ifdef __linux__
+#      include <sys/ioctl.h>
+       // (<fcntl.h> only declares those with _GNU_SOURCE)
+       ssize_t vmsplice(int fd, const struct iovec *iov, size_t nr_segs,
+                        unsigned int flags);
+#      ifndef  F_GETPIPE_SZ
+#         define F_GETPIPE_SZ   1032
+#      endif
+#   endif
+#endif
+
+// settings for the next outputs
+static int          output_buffers;
+static outputPolicy output_policy;
+
+void output_configure(int buffers, outputPolicy policy)
+{
+   output_buffers = (buffers > 0) ? buffers : 0;
+   output_policy  = policy;
+}
+
+
+// make sure a buffer can hold `size` bytes
+static int output_reserve(outputBuffer *buffer, size_t size)
+{
+   if (size <= buffer->capacity)
+      return 0;
+   size_t capacity = 2 * buffer->capacity;
+   if (capacity < size)  capacity = size;
+   unsigned char *data = realloc(buffer->data, capacity);
+   if (data == NULL)
+      return -1;
+   buffer->data     = data;
+   buffer->capacity = capacity;
+   return 0;
+}
+
+// write a buffer on the stream, return 0 iff successful
+static int output_flush(FILE *stream, const outputBuffer *buffer)
+{
+   if (buffer)
+      fwrite(buffer->data, 1, buffer->size, stream);
+   fflush(stream);
+   int err = ferror(stream);
+   if (unlikely(err))
+      clearerr(stream);
+   return err;
+}
+
+// the writer thread
+static int output_writer(void *arg)
+{  output *out = arg;
+   mutex_lock(&out->lock);
+   while (true) {
+      while (out->queued == 0 && !out->quit)
+         condition_wait(&out->wake, &out->lock);
+      if (out->queued == 0) // (and quit)
+         break;
+
+      // take the oldest frame and write it (without holding the lock)
+      outputBuffer *frame = out->queue[out->head];
+      out->head = (out->head + 1) % out->count;
+      out->queued--;
+      mutex_unlock(&out->lock);
+      int err = output_flush(out->stream, frame);
+      mutex_lock(&out->lock);
+
+      // release its buffer
+      frame->size = 0;
+      out->pool[out->free++] = frame;
+      if (err)  out->errors++;
+      condition_signal(&out->done);
+   }
+   mutex_unlock(&out->lock);
+   return 0;
+}
+
+
+//===< vectored frames >========================================================
+#if OUTPUT_VECTORED
+
+// set up vectored frames if the stream has a file descriptor
+static void output_initVectored(output *out)
+{
+   out->fd = -1;
+   int fd = fileno(out->stream);
+   if (fd < 0)
+      return;
+   struct stat st;
+   out->pipe   = (fstat(fd, &st) == 0) && S_ISFIFO(st.st_mode);
+   long max    = sysconf(_SC_IOV_MAX);
+   out->iovMax = (max > 0 && max < INT_MAX) ? (int)max : 16;
+   out->fd     = fd;
+}
+
+// if the last frame was spliced, its pages may still be in the pipe: wait
+// until they are read (before they are released or changed by the renderer),
+// or until the reader is gone. If the reader doesn't read them in time, this
+// returns an error and the next frames aren't spliced anymore.
+static int output_waitSpliced(output *out)
+{
+   int err = 0;
+#ifdef __linux__
+   int pending;
+   uint64_t deadline = clock_ns() + UINT64_C(1000000) * OUTPUT_SPLICE_TIMEOUT;
+   while (out->spliced && ioctl(out->fd, FIONREAD, &pending) == 0 && pending > 0) {
+      struct pollfd reader = { .fd = out->fd };
+      if (poll(&reader, 1, 0) > 0 && (reader.revents & (POLLERR | POLLHUP)))
+         break; // (no one will read the pages anymore)
+      if (!err && clock_ns() >= deadline) {
+         out->pipe = false;
+         err = -1;
+      }
+      sleep_ms(1);
+   }
+#endif
+   out->spliced = false;
+   return err;
+}
+
+static void output_dropVectored(output *out)
+{
+   output_waitSpliced(out);
+   free(out->iov);
+   out->iov         = NULL;
+   out->iovCapacity = 0;
+   out->iovCount    = 0;
+}
+
+// size of a pipe, if we may splice a frame of `size` bytes into it, or else 0.
+// (Spliced pages are only referenced by the pipe: a frame which is at least as
+//  big as the pipe pushes the pages of the previous frame out of it)
+static size_t output_spliceable(output *out, size_t size)
+{
+#ifdef __linux__
+   if (out->pipe) {
+      int pipe_size = fcntl(out->fd, F_GETPIPE_SZ);
+      if (pipe_size > 0 && size >= (size_t)pipe_size)
+         return pipe_size;
+   }
+#endif
+   (void)out; (void)size;
+   return 0;
+}
+
+// write the vector of the current frame, return 0 iff successful
+static int output_writeVector(output *out)
+{
+   struct iovec *iov   = out->iov;
+   int           count = out->iovCount;
+   out->iovCount = 0;
+
+   size_t size = 0;
+   for (int i = 0; i < count; i++)
+       size += iov[i].iov_len;
+   bool splice = output_spliceable(out, size);
+   int  err    = 0;
+   if (!splice)
+      // (a smaller frame doesn't push the pages of a spliced frame out)
+      err = output_waitSpliced(out);
+   out->spliced = splice;
+
+   while (count > 0) {
+      int n = (count < out->iovMax) ? count : out->iovMax;
+      ssize_t written;
+#ifdef __linux__
+      if (splice) {
+         written = vmsplice(out->fd, iov, n, 0);
+         if (written < 0 && errno != EINTR) {
+            // not supported: don't try again
+            splice    = false;
+            out->pipe = false;
+            continue;
+         }
+      } else
+#endif
+      {
+         written = writev(out->fd, iov, n);
+      }
+      if (written < 0) {
+         if (errno == EINTR)
+            continue;
+         return -1;
+      }
+
+      // skip what was written
+      while (count > 0 && (size_t)written >= iov->iov_len) {
+         written -= iov->iov_len;
+         iov++;
+         count--;
+      }
+      if (count > 0) {
+         iov->iov_base  = (char*)iov->iov_base + written;
+         iov->iov_len  -= written;
+      }
+   }
+   return err;
+}
+
+bool output_isVectored(const output *out)
+{ return out->fd >= 0; }
+
+int output_writeRef(output *out, const void *data, size_t size)
+{
+   if (out->fd < 0)
+      return output_write(out, data, size);
+   if (size == 0)
+      return 0;
+   out->written += size;
+
+   // extend the last vector if the data follows it
+   if (out->iovCount > 0) {
+      struct iovec *last = &out->iov[out->iovCount - 1];
+      if ((const char*)last->iov_base + last->iov_len == (const char*)data) {
+         last->iov_len += size;
+         return 0;
+      }
+   }
+
+   if (out->iovCount == out->iovCapacity) {
+      int capacity = (out->iovCapacity) ? 2 * out->iovCapacity : 64;
+      struct iovec *iov = realloc(out->iov, capacity * sizeof(*iov));
+      if (iov == NULL)
+         return -1;
+      out->iov         = iov;
+      out->iovCapacity = capacity;
+   }
+   out->iov[out->iovCount++] = (struct iovec){ .iov_base = (void*)data,
+                                               .iov_len  = size };
+   return 0;
+}
+
+// append a copy of small data to a vectored frame
+static int output_writeCopy(output *out, const void *data, size_t size)
+{
+   if (out->scratchSize + size <= OUTPUT_SCRATCH) {
+      unsigned char *copy = out->scratch[out->parity] + out->scratchSize;
+      memcpy(copy, data, size);
+      out->scratchSize += size;
+      return output_writeRef(out, copy, size);
+   }
+
+   // too big: write what we have and that data now
+   if (output_writeRef(out, data, size))
+      return -1;
+   return output_writeVector(out);
+}
+
+// write a vectored frame
+static int output_submitVectored(output *out)
+{
+   // (data may have been put in the stream before the frame)
+   fflush(out->stream);
+   int err = output_writeVector(out);
+   out->parity      = !out->parity;
+   out->scratchSize = 0;
+   return err;
+}
+
+#else
+
+static void output_initVectored(output *out)  { (void)out; }
+static void output_dropVectored(output *out)  { (void)out; }
+
+bool output_isVectored(const output *out)
+{ (void)out; return false; }
+
+int output_writeRef(output *out, const void *data, size_t size)
+{ return output_write(out, data, size); }
+
+#endif
+//===</ vectored frames >=======================================================
+
+
+int output_init(output *out, FILE *stream, size_t capacity)
+{
+   *out = (output){ .stream = stream,
+                    .policy = output_policy,
+                    .count  = THREAD_SUPPORT ? output_buffers : 0 };
+   if (out->count == 0) {
+      output_initVectored(out);
+      return 0;
+   }
+#if OUTPUT_VECTORED
+   out->fd = -1; // (no vectored frames with the writer thread)
+#endif
+
+   // allocate the buffers: `count` in the queue, plus the one being encoded
+   // and the one being written.
+   int n = out->count + 2;
+   out->buffers = calloc(n, sizeof(*out->buffers));
+   out->queue   = calloc(n, sizeof(*out->queue));
+   out->pool    = calloc(n, sizeof(*out->pool));
+   if (out->buffers == NULL || out->queue == NULL || out->pool == NULL)
+      goto error_buffers;
+   for (int i = 0; i < n; i++) {
+       if (output_reserve(&out->buffers[i], capacity))
+          goto error_buffers;
+       out->pool[i] = &out->buffers[i];
+   }
+   out->free  = n - 1;
+   out->frame = out->pool[n - 1];
+
+   // start the writer thread
+   if (mutex_init(&out->lock))              goto error_buffers;
+   if (condition_init(&out->wake))          goto error_wake;
+   if (condition_init(&out->done))          goto error_done;
+   if (thread_create(&out->writer, &output_writer, out))
+      goto error_thread;
+   return 0;
+
+error_thread:
+   condition_drop(&out->done);
+error_done:
+   condition_drop(&out->wake);
+error_wake:
+   mutex_drop(&out->lock);
+error_buffers:
+   if (out->buffers)
+      for (int i = 0; i < n; i++)
+          free(out->buffers[i].data);
+   free(out->buffers);
+   free(out->queue);
+   free(out->pool);
+   *out = (output){ .stream = stream };
+#if OUTPUT_VECTORED
+   out->fd = -1;
+#endif
+   return -1;
+}
+
+void output_drop(output *out)
+{
+   if (out->frame == NULL) {
+      output_dropVectored(out);
+      return;
+   }
+
+   // let the writer thread write the waiting frames and finish
+   mutex_lock(&out->lock);
+   out->quit = true;
+   condition_signal(&out->wake);
+   mutex_unlock(&out->lock);
+   thread_join(&out->writer);
+
+   condition_drop(&out->done);
+   condition_drop(&out->wake);
+   mutex_drop(&out->lock);
+   for (int i = 0; i < out->count + 2; i++)
+       free(out->buffers[i].data);
+   free(out->buffers);
+   free(out->queue);
+   free(out->pool);
+   *out = (output){ .stream = out->stream };
+#if OUTPUT_VECTORED
+   out->fd = -1;
+#endif
+}
+
+int output_write(output *out, const void *data, size_t size)
+{
+   outputBuffer *frame = out->frame;
+#if OUTPUT_VECTORED
+   if (out->fd >= 0)
+      return output_writeCopy(out, data, size);
+#endif
+   out->written += size;
+   if (frame == NULL)
+      return fwrite(data, 1, size, out->stream) != size;
+   if (output_reserve(frame, frame->size + size))
+      return -1;
+   memcpy(frame->data + frame->size, data, size);
+   frame->size += size;
+   return 0;
+}
+
+// end the current frame (see `output_submit`)
+static int output_submitFrame(output *out)
+{
+#if OUTPUT_VECTORED
+   if (out->fd >= 0)
+      return output_submitVectored(out);
+#endif
+   if (out->frame == NULL)
+      return output_flush(out->stream, NULL);
+
+   int ret = 0;
+   mutex_lock(&out->lock);
+   if (out->frame->size == 0) {
+      // an empty frame isn't queued (it would only take the place of a frame
+      // in the queue, or make the policy drop one)
+      goto end;
+   }
+   if (out->queued == out->count) {
+      switch (out->policy) {
+         default: // fallthrough
+         case OUTPUT_BLOCK:
+            while (out->queued == out->count)
+               condition_wait(&out->done, &out->lock);
+            break;
+
+         case OUTPUT_DROP_OLDEST: {
+            outputBuffer *oldest = out->queue[out->head];
+            out->head = (out->head + 1) % out->count;
+            out->queued--;
+            oldest->size = 0;
+            out->pool[out->free++] = oldest;
+            rendererStats_drop();
+            ret = 1;
+            break;
+         }
+
+         case OUTPUT_DROP_NEWEST:
+            out->frame->size = 0;
+            rendererStats_drop();
+            mutex_unlock(&out->lock);
+            return 1;
+      }
+   }
+
+   // queue the frame, and continue with a free buffer
+   out->queue[(out->head + out->queued) % out->count] = out->frame;
+   out->queued++;
+   out->frame = out->pool[--out->free];
+   condition_signal(&out->wake);
+
+end:
+   // report the errors of the writer thread
+   if (out->errors) {
+      out->errors = 0;
+      ret = -1;
+   }
+   mutex_unlock(&out->lock);
+   return ret;
+}
+
+int output_submit(output *out)
+{
+   uint64_t start = rendererStats_clock();
+   int ret = output_submitFrame(out);
+   rendererStats_present(start, out->written);
+   out->written = 0;
+   return ret;
+}
+
+#endif //KONPU_PLATFORM_LIBC
@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * @file
+ * Output of the renderers which write their frames on a stream (such as the
+ * PPM, Y4M, or PseudoGraphics renderers).
+ *
+ * A renderer encodes a frame with `output_write`/`output_putc` and ends it
+ * with `output_submit`. By default, this simply writes on the stream. But the
+ * output can also have a ring of buffers, so that frames are encoded in memory
+ * and a writer thread writes them in the background. Then, when the consumer
+ * of the stream can't keep up (for example, a slow terminal or a media player
+ * reading from a pipe), `render()` doesn't have to wait: a policy decides
+ * which frames are dropped.
+ *
+ * On POSIX, when frames are written directly on a stream backed by a file
+ * descriptor, a renderer may also assemble a frame by reference, as a vector
+ * of its own buffers (see `output_writeRef`). The frame is then written at once
+ * with `writev`, or even with `vmsplice` when the file descriptor is a pipe,
+ * without going through the buffer of the stream.
+ ******************************************************************************/
+#ifndef  KONPU_OUTPUT_H
+#define  KONPU_OUTPUT_H
+#include "platform.h"
+#include "c.h"
+#include "thread.h"
+
+#if KONPU_PLATFORM_LIBC
+#include <stdio.h>
+
+/// @brief OUTPUT_VECTORED settings:
+/// non-zero iff frames may be assembled as vectors and written with `writev`
+/// or `vmsplice` (by default, on the POSIX platform)
+#ifndef    OUTPUT_VECTORED
+#   define OUTPUT_VECTORED   KONPU_PLATFORM_POSIX
+#endif
+#if OUTPUT_VECTORED
+#   include <sys/uio.h>
+#endif
+
+/// @brief OUTPUT_SPLICE_TIMEOUT settings:
+/// time (in ms) after which a reader of a pipe which hasn't read the pages of
+/// a spliced frame is stalled: the frame being submitted reports an error, and
+/// the next frames are copied into the pipe instead. (The pages are still
+/// waited for, as their memory can't be reused until they are read)
+#ifndef    OUTPUT_SPLICE_TIMEOUT
+#   define OUTPUT_SPLICE_TIMEOUT   1000
+#endif
+
+// size of the buffers for the small data copied in vectored frames
+#define OUTPUT_SCRATCH   256
+
+/// @brief what to do when a frame is submitted while the ring is full
+typedef enum outputPolicy {
+   OUTPUT_BLOCK,        ///< wait until the writer thread has written a frame
+   OUTPUT_DROP_OLDEST,  ///< drop the oldest frame which is waiting
+   OUTPUT_DROP_NEWEST,  ///< drop the frame being submitted
+} outputPolicy;
+
+/// @brief set how the stream renderers which are initialized next output
+///        their frames (by default: 0 buffers, ie: they write directly)
+/// @param buffers number of frames which can wait to be written by a writer
+///                thread. If <= 0 (or if threads aren't supported), frames
+///                are written directly by `render()`.
+/// @param policy  what to do when `buffers` frames are already waiting
+void output_configure(int buffers, outputPolicy policy);
+
+
+//--- interface for the renderers ----------------------------------------------
+
+// a buffer holding an encoded frame
+typedef struct outputBuffer {
+   unsigned char *data;
+   size_t         size;
+   size_t         capacity;
+} outputBuffer;
+
+// an output
+typedef struct output {
+   FILE          *stream;
+   outputBuffer  *frame;     // frame being encoded (NULL: write directly)
+   outputPolicy   policy;
+   int            count;     // number of frames which can wait
+   outputBuffer  *buffers;   // (count + 2 buffers)
+   outputBuffer **queue;     // frames waiting to be written (circular)
+   outputBuffer **pool;      // buffers which are free
+   int            head;      // index of the oldest frame in the queue
+   int            queued;    // number of frames in the queue
+   int            free;      // number of buffers in the pool
+   bool           quit;
+   unsigned       errors;    // number of write errors in the writer thread
+   size_t         written;   // bytes of the current frame (for the statistics)
+   thread         writer;
+   mutex          lock;
+   condition      wake;      // signals frames to the writer
+   condition      done;      // signals written frames to `output_submit`
+#if OUTPUT_VECTORED
+   int            fd;        // file descriptor for vectored frames (or -1)
+   struct iovec  *iov;       // vector of the current frame
+   int            iovCount;
+   int            iovCapacity;
+   int            iovMax;    // max number of vectors in one system call
+   bool           pipe;      // whether `fd` is a pipe (to try `vmsplice`)
+   bool           spliced;   // whether the last frame was spliced
+   int            parity;    // which scratch buffer is used by this frame
+   size_t         scratchSize;
+   unsigned char  scratch[2][OUTPUT_SCRATCH]; // small data copied in frames
+#endif
+} output;
+
+// initialize an output on the given stream, with the settings given by
+// `output_configure`. `capacity` is the expected size of a frame (the buffers
+// are allocated with that size, but still grow if needed).
+// Return 0 iff successful.
+int    output_init(output *out, FILE *stream, size_t capacity);
+
+// write the waiting frames, and release the output
+void   output_drop(output *out);
+
+// append data to the current frame
+int    output_write(output *out, const void *data, size_t size);
+static inline void output_putc(output *out, unsigned char c);
+
+// vectored frames:
+// If the output is vectored, `output_writeRef` appends data to the current
+// frame by reference: that data must stay unchanged until the frame is
+// submitted, and even until the next frame is submitted, because the pages of
+// a frame may still be in the pipe after `vmsplice` returns. So a renderer
+// should alternate between two sets of buffers for its frames. (Don't mix
+// `output_putc` with the other functions in a vectored frame.)
+// If the output isn't vectored, `output_writeRef` is `output_write`.
+bool   output_isVectored(const output *out);
+int    output_writeRef(output *out, const void *data, size_t size);
+
+// end the current frame: write it, or queue it for the writer thread (but an
+// empty frame is never queued, so it never makes the policy drop a frame).
+// Return non-zero if an error occurred or if a frame was dropped.
+// (this also counts the frame in the statistics of the renderer, see
+//  `rendererStats_present`, and the dropped frames, see `rendererStats_drop`)
+int    output_submit(output *out);
+
+
+//--- inline implementation ----------------------------------------------------
+
+static inline void output_putc(output *out, unsigned char c)
+{
+   outputBuffer *frame = out->frame;
+   out->written++;
+   if (frame == NULL)
+      putc(c, out->stream);
+   else if (frame->size < frame->capacity)
+      frame->data[frame->size++] = c;
+   else {
+      out->written--; // (counted by `output_write`)
+      output_write(out, &c, 1);
+   }
+}
+
+#endif //KONPU_PLATFORM_LIBC
+#endif //KONPU_OUTPUT_H
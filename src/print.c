@@ -15,6 +15,7 @@ void print_quadrant(canvas cvas, int x, int y, const char* str)
 {  CANVAS_ASSERT(cvas);
    assert(str);
    //TODO: CANVAS_CLAMP(....
+   TRACE_BEGIN("print_quadrant");
 
    // half-grid coordinates to grid coordinates + quandrant location indicator
    bool left = x % 2; // print quadrant of the left side of a glyph?
@@ -68,4 +69,5 @@ void print_quadrant(canvas cvas, int x, int y, const char* str)
    // if we finished one the bottom-right corner, we need to make sure to clamp the
    // cursor there
    if (x >= cvas.width)  x = cvas.width;
+   TRACE_END("print_quadrant");
 }
@@ -1,4 +1,8 @@
 #include "renderer.h"
+#include "screen.h"
+#include "thread.h"
+#include "util.h"
+#include "bits.h"
 
 struct rendererObject rendererSingleton = {
    .id     = RENDERER_NULL,
@@ -6,6 +10,10 @@ struct rendererObject rendererSingleton = {
    .drop   = &renderer_null
 };
 
+bool rendererAsync_enabled;
+
+
+static void rendererStats_dropped(void);
 
 int renderer_null(void)
 {
@@ -23,6 +31,338 @@ int renderer_drop(void)
    rendererSingleton.id     = RENDERER_NULL;
    rendererSingleton.render = &renderer_null;
    rendererSingleton.drop   = &renderer_null;
+   rendererStats_dropped();
 
    return (rendererSingleton.error)? ret : 0;
 }
+
+
+//===< asynchronous rendering >=================================================
+
+#if RENDERER_STATS
+static void rendererStats_count(uint64_t start, bool shared);
+#endif
+
+#if THREAD_SUPPORT
+
+// Triple buffering: `render()` copies the screen into its `write` snapshot,
+// then swaps it with the `middle` one, which the render thread swaps with its
+// `read` snapshot to paint it. The index in `middle` is flagged with
+// RENDERER_ASYNC_FRESH if it's a frame which the render thread hasn't taken
+// yet (if `render()` swaps it again, that stale frame is dropped)
+#define RENDERER_ASYNC_FRESH   4
+
+static struct {
+   struct rendererObject renderer; // renderer running in the render thread
+   thread    thread;
+   mutex     lock;       // (only to let the render thread sleep when idle)
+   condition wake;
+   bool      quit;       // (protected by `lock`)
+   atomicInt middle;     // index of the snapshot in the middle (+ fresh flag)
+   atomicInt errors;     // number of frames which failed in the render thread
+   int       write;      // index of the snapshot written by `render()`
+   int       read;       // index of the snapshot read by the render thread
+   uint64_t  snapshot[3][GRID_WIDTH * GRID_HEIGHT];
+   glyphColors colors[3][GRID_WIDTH * GRID_HEIGHT]; // (with the snapshots)
+   int       width[3], height[3];                    // (of the snapshots)
+} rendererAsync;
+
+// the render thread
+static int rendererAsync_thread(void *arg)
+{  (void)arg;
+   while (true) {
+      mutex_lock(&rendererAsync.lock);
+      while (!rendererAsync.quit &&
+             !(atomicInt_load(&rendererAsync.middle) & RENDERER_ASYNC_FRESH))
+         condition_wait(&rendererAsync.wake, &rendererAsync.lock);
+      bool quit = rendererAsync.quit;
+      mutex_unlock(&rendererAsync.lock);
+      // (when quitting, the last snapshot is still painted if it's fresh)
+      if (quit && !(atomicInt_load(&rendererAsync.middle) & RENDERER_ASYNC_FRESH))
+         return 0;
+
+      // take the latest snapshot, and paint it
+      int middle = atomicInt_exchange(&rendererAsync.middle, rendererAsync.read);
+      int read   = middle & ~RENDERER_ASYNC_FRESH;
+      rendererAsync.read = read;
+      rendererScreen = (canvas){ .glyphs = rendererAsync.snapshot[read],
+                                 .width  = rendererAsync.width[read],
+                                 .height = rendererAsync.height[read],
+                                 .stride = rendererAsync.width[read] };
+      rendererColors = rendererAsync.colors[read];
+      TRACE_BEGIN("rendererAsync_thread");
+      uint64_t start = rendererStats_clock();
+      if (unlikely( (*rendererAsync.renderer.render)() ))
+         atomicInt_add(&rendererAsync.errors, 1);
+      TRACE_END("rendererAsync_thread");
+#if RENDERER_STATS
+      rendererStats_count(start, true);
+#else
+      (void)start;
+#endif
+   }
+}
+
+// `render` function in asynchronous mode
+static int rendererAsync_render(void)
+{
+   // copy the screen (and its colors) into our snapshot, with the current
+   // dimensions of the screen
+   TRACE_BEGIN("rendererAsync_render");
+   assert(screen.width * screen.height <= GRID_WIDTH * GRID_HEIGHT);
+   uint64_t    *snapshot = rendererAsync.snapshot[rendererAsync.write];
+   glyphColors *colors   = rendererAsync.colors[rendererAsync.write];
+   rendererAsync.width[rendererAsync.write]  = screen.width;
+   rendererAsync.height[rendererAsync.write] = screen.height;
+   for (int y = 0; y < screen.height; y++) {
+       const uint64_t *row = canvas_glyphPointer(screen, 0, y);
+       ptrdiff_t index = row - screen.glyphs; // (of the row in screenColors)
+       for (int x = 0; x < screen.width; x++) {
+           *snapshot++ = row[x];
+           *colors++   = screenColors[index + x];
+       }
+   }
+
+   // publish it
+   int middle = atomicInt_exchange(&rendererAsync.middle,
+                                   rendererAsync.write | RENDERER_ASYNC_FRESH);
+   rendererAsync.write = middle & ~RENDERER_ASYNC_FRESH;
+   mutex_lock(&rendererAsync.lock);
+   condition_signal(&rendererAsync.wake);
+   mutex_unlock(&rendererAsync.lock);
+
+   // report the errors from the render thread
+   rendererSingleton.error += (unsigned)atomicInt_exchange(&rendererAsync.errors, 0);
+   TRACE_END("rendererAsync_render");
+   return 0;
+}
+
+// `drop` function in asynchronous mode
+static int rendererAsync_drop(void)
+{
+   renderer_async(false);
+   return (*rendererSingleton.drop)();
+}
+
+int renderer_async(bool enable)
+{
+   if (enable == rendererAsync_enabled)
+      return 0;
+
+   if (enable) {
+      assert(screen.width * screen.height <= GRID_WIDTH * GRID_HEIGHT);
+      if (mutex_init(&rendererAsync.lock))
+         return -1;
+      if (condition_init(&rendererAsync.wake)) {
+         mutex_drop(&rendererAsync.lock);
+         return -1;
+      }
+      rendererAsync.renderer = rendererSingleton;
+      rendererAsync.quit     = false;
+      rendererAsync.write    = 0;
+      rendererAsync.read     = 2;
+      atomicInt_store(&rendererAsync.middle, 1);
+      atomicInt_store(&rendererAsync.errors, 0);
+      if (thread_create(&rendererAsync.thread, &rendererAsync_thread, NULL)) {
+         condition_drop(&rendererAsync.wake);
+         mutex_drop(&rendererAsync.lock);
+         return -1;
+      }
+      rendererSingleton.render = &rendererAsync_render;
+      rendererSingleton.drop   = &rendererAsync_drop;
+
+   } else {
+      mutex_lock(&rendererAsync.lock);
+      rendererAsync.quit = true;
+      condition_signal(&rendererAsync.wake);
+      mutex_unlock(&rendererAsync.lock);
+      thread_join(&rendererAsync.thread);
+      condition_drop(&rendererAsync.wake);
+      mutex_drop(&rendererAsync.lock);
+
+      rendererScreen = screen;
+      rendererColors = screenColors;
+      rendererSingleton.render = rendererAsync.renderer.render;
+      rendererSingleton.drop   = rendererAsync.renderer.drop;
+      rendererSingleton.error += (unsigned)atomicInt_load(&rendererAsync.errors);
+   }
+   rendererAsync_enabled = enable;
+   return 0;
+}
+
+#else
+
+int renderer_async(bool enable)
+{ return (enable)? -1 : 0; }
+
+#endif
+
+//===</ asynchronous rendering >================================================
+
+
+
+//===< statistics >=============================================================
+
+#if RENDERER_STATS
+
+static struct {
+   rendererStats stats;
+   bool          dropped; // whether the renderer of the stats was dropped
+   // (those are only used by the thread painting the frames)
+   uint64_t      present; // time spent presenting the current frame
+   size_t        bytes;   // bytes output for the current frame
+   unsigned      drops;   // frames dropped by the output for the current frame
+} rendererStatsState;
+
+// when rendering asynchronously, the stats are updated by the render thread
+// under the lock of the asynchronous rendering (`shared` is true then)
+static void rendererStats_lock(bool shared)
+{
+#if THREAD_SUPPORT
+   if (shared)   mutex_lock(&rendererAsync.lock);
+#else
+   (void)shared;
+#endif
+}
+
+static void rendererStats_unlock(bool shared)
+{
+#if THREAD_SUPPORT
+   if (shared)   mutex_unlock(&rendererAsync.lock);
+#else
+   (void)shared;
+#endif
+}
+
+// bucket of the histogram for a frame duration (in ns): [0,4[ us have a bucket
+// for each microsecond, then the durations in [2^n, 2^(n+1)[ us are split in
+// four buckets.
+static int rendererStats_bucket(uint64_t ns)
+{  uint64_t us = ns / 1000;
+   if (us < 4)
+      return (int)us;
+   int octave = 63 - uint64_clz(us); // (>= 2)
+   int bucket = 4 * (octave - 1) + (int)((us >> (octave - 2)) & 3);
+   return (bucket < RENDERER_STATS_BUCKETS) ? bucket : RENDERER_STATS_BUCKETS - 1;
+}
+
+// upper bound of the durations of a bucket (in ns)
+static uint64_t rendererStats_bucketEnd(int bucket)
+{  if (bucket < 4)
+      return (uint64_t)(bucket + 1) * 1000;
+   int octave = bucket / 4 + 1;
+   return ((uint64_t)(5 + bucket % 4) << (octave - 2)) * 1000;
+}
+
+// count a frame which started at `start`
+static void rendererStats_count(uint64_t start, bool shared)
+{
+   uint64_t duration = clock_ns() - start;
+   uint64_t present  = rendererStatsState.present;
+   if (present > duration)   present = duration;
+   rendererStats_lock(shared);
+   if (rendererStatsState.dropped) {
+      // the first frame of a new renderer: forget those of the dropped one
+      rendererStatsState.stats   = (rendererStats){0};
+      rendererStatsState.dropped = false;
+   }
+   rendererStatsState.stats.frames++;
+   rendererStatsState.stats.presentNs += present;
+   rendererStatsState.stats.convertNs += duration - present;
+   rendererStatsState.stats.bytes     += rendererStatsState.bytes;
+   rendererStatsState.stats.dropped   += rendererStatsState.drops;
+   rendererStatsState.stats.histogram[rendererStats_bucket(duration)]++;
+   rendererStats_unlock(shared);
+   rendererStatsState.present = 0;
+   rendererStatsState.bytes   = 0;
+   rendererStatsState.drops   = 0;
+}
+
+uint64_t rendererStats_clock(void)
+{
+   return clock_ns();
+}
+
+void rendererStats_present(uint64_t start, size_t bytes)
+{
+   rendererStatsState.present += clock_ns() - start;
+   rendererStatsState.bytes   += bytes;
+}
+
+void rendererStats_drop(void)
+{
+   rendererStatsState.drops++;
+}
+
+void rendererStats_frame(uint64_t start)
+{
+#if THREAD_SUPPORT
+   // (when rendering asynchronously, the render thread counts the frames)
+   if (rendererAsync_enabled)
+      return;
+#endif
+   rendererStats_count(start, false);
+}
+
+rendererStats renderer_getStats(void)
+{
+   rendererStats_lock(rendererAsync_enabled);
+   rendererStats stats = rendererStatsState.stats;
+   rendererStats_unlock(rendererAsync_enabled);
+   return stats;
+}
+
+void renderer_resetStats(void)
+{
+   rendererStats_lock(rendererAsync_enabled);
+   rendererStatsState.stats   = (rendererStats){0};
+   rendererStatsState.dropped = false;
+   rendererStats_unlock(rendererAsync_enabled);
+}
+
+static void rendererStats_dropped(void)
+{
+   rendererStatsState.dropped = true;
+   rendererStatsState.present = 0;
+   rendererStatsState.bytes   = 0;
+   rendererStatsState.drops   = 0;
+}
+
+uint64_t rendererStats_percentile(const rendererStats *stats, double p)
+{
+   uint64_t count = 0;
+   for (int i = 0; i < RENDERER_STATS_BUCKETS; i++)
+       count += stats->histogram[i];
+   if (count == 0)
+      return 0;
+
+   // rank of the percentile, ie: ceil(p * count), in [1,count]
+   double   exact = p * count;
+   uint64_t rank  = (exact <= 1.) ? 1 : (exact >= count) ? count : (uint64_t)exact;
+   if (rank < exact)   rank++;
+
+   for (int i = 0; i < RENDERER_STATS_BUCKETS; i++) {
+       if (rank <= stats->histogram[i])
+          return rendererStats_bucketEnd(i);
+       rank -= stats->histogram[i];
+   }
+   return rendererStats_bucketEnd(RENDERER_STATS_BUCKETS - 1);
+}
+
+#else
+
+rendererStats renderer_getStats(void)
+{ return (rendererStats){0}; }
+
+void renderer_resetStats(void)
+{}
+
+static void rendererStats_dropped(void)
+{}
+
+uint64_t rendererStats_percentile(const rendererStats *stats, double p)
+{ (void)stats; (void)p; return 0; }
+
+#endif
+
+//===</ statistics >============================================================
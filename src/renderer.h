@@ -10,6 +10,8 @@
 #define  KONPU_RENDERER_H
 #include "platform.h"
 #include "c.h"
+#include "screen.h"
+#include "trace.h"
 
 
 /*  maybe TODO elsewhere?
@@ -37,6 +39,24 @@ static inline  void  render(void);
 ///             an extra error code set by the renderer.
 int renderer_drop(void);
 
+/// @brief   render asynchronously, or not, with the active renderer
+/// @param   enable true to start asynchronous rendering, false to stop it
+/// @return  0 iff successful (it fails if threads aren't supported)
+/// @details In asynchronous mode, `render()` only copies the screen into a
+///          snapshot and returns, while a render thread paints the latest
+///          snapshot with the active renderer. If `render()` is called faster
+///          than the renderer can paint, the stale snapshots are dropped.
+///          The errors of the render thread are counted in the error count
+///          at the next `render()`.
+///          Dropping the renderer stops asynchronous rendering. Stopping it
+///          waits until the last snapshot passed to `render()` is painted.
+///          Note that the renderer's functions run in the render thread: some
+///          platforms may not allow it (for example, SDL's accelerated
+///          renderers must be used from the thread which created them), and
+///          you shouldn't call the functions of the active renderer (such as
+///          changing its settings) while rendering asynchronously.
+int renderer_async(bool enable);
+
 /// @brief this is the "Null" renderer, which doesn't display anything.
 /// This is the default renderer at the start of the program
 ///                              or after `render_drop()` is called.
@@ -56,11 +76,68 @@ static inline int renderer_getId(void);
 static inline int renderer_getError(void);
 
 
+//--- statistics ---------------------------------------------------------------
+
+/// @brief RENDERER_STATS settings:
+/// non-zero iff the renderers collect statistics about their frames (this only
+/// costs a few readings of the clock per frame). Define it to 0 to compile the
+/// collection out: the statistics are then always zero.
+#ifndef    RENDERER_STATS
+#   define RENDERER_STATS  1
+#endif
+
+/// @brief number of buckets of the histogram of the durations of the frames
+#define RENDERER_STATS_BUCKETS  80
+
+/// @brief statistics about the frames of the active renderer
+/// (durations are in nanoseconds)
+typedef struct rendererStats {
+   uint64_t frames;     ///< number of frames rendered
+   uint64_t convertNs;  ///< time spent converting the screen into the format
+                        ///<   of the renderer (ie: the time of the frames
+                        ///<   which isn't spent presenting them)
+   uint64_t presentNs;  ///< time spent presenting the frames: submitting them
+                        ///<   to their output (stream renderers), or updating
+                        ///<   and presenting the window (SDL2 renderer)
+   uint64_t bytes;      ///< number of bytes output (stream renderers)
+   uint64_t dropped;    ///< number of frames which were dropped instead of
+                        ///<   being output (stream renderers with a policy
+                        ///<   which drops frames, see `output_configure`)
+   uint32_t histogram[RENDERER_STATS_BUCKETS];
+                        ///< number of frames by duration: the buckets split
+                        ///<   each power of two of microseconds in four, the
+                        ///<   last bucket taking all longer frames
+                        ///<   (see `rendererStats_percentile`)
+} rendererStats;
+
+/// @brief   return the statistics of the active renderer since it has been
+///          initialized (or since `renderer_resetStats()`)
+/// @details When rendering asynchronously, the frames are those painted by the
+///          render thread (the statistics are a consistent snapshot, taken
+///          between two of its frames).
+///          After the renderer is dropped, its statistics are kept (so those
+///          of a finished run can still be read) until the next renderer
+///          paints its first frame.
+rendererStats renderer_getStats(void);
+
+/// @brief   reset the statistics of the active renderer
+void renderer_resetStats(void);
+
+/// @brief   return a percentile of the durations of the frames (in ns)
+/// @param   p the percentile in [0,1], for example: 0.5 for the median, 0.99
+///          for the 99th percentile.
+/// @return  an upper bound of that percentile (the buckets of the histogram
+///          have a precision of 25%), or 0 if there are no frames.
+uint64_t rendererStats_percentile(const rendererStats *stats, double p);
+
+
 //--- advanced: interface to define your own custom renderer -------------------
 
 /// @brief a renderer object
 struct rendererObject {
-   int (*render)(void);  ///< function which renders the "screen" canvas
+   int (*render)(void);  ///< function which renders the `rendererScreen`
+                         ///<   canvas (ie: the "screen" canvas, or a snapshot
+                         ///<   of it when rendering asynchronously)
    int (*drop)(void);    ///< function which releases possible resources that
                          ///<   were hold by the renderer.
    // internally kept as unsigned to prevent UB on overflow:
@@ -85,6 +162,21 @@ struct rendererObject {
 /// @return 0
 int renderer_null(void);
 
+/// @brief for the statistics, a renderer tells the time it spent presenting
+///        the current frame (the stream renderers do it via `output_submit`)
+/// @param start time when it started presenting it, from `rendererStats_clock`
+/// @param bytes number of bytes output for that frame
+/// (and a stream renderer tells when its output drops a frame)
+#if RENDERER_STATS
+   uint64_t rendererStats_clock(void);
+   void     rendererStats_present(uint64_t start, size_t bytes);
+   void     rendererStats_drop(void);
+#else
+#  define   rendererStats_clock()                 UINT64_C(0)
+#  define   rendererStats_present(start, bytes)   ((void)(start), (void)(bytes))
+#  define   rendererStats_drop()                  ((void)0)
+#endif
+
 
 //--- inline implementation ----------------------------------------------------
 
@@ -93,11 +185,34 @@ int renderer_null(void);
 /// possible to call the `render()` function, but it will have no effect.
 extern struct rendererObject rendererSingleton;
 
+// end a frame which started at `start` (from `rendererStats_clock`) in the
+// statistics
+#if RENDERER_STATS
+   void rendererStats_frame(uint64_t start);
+#endif
+
+// whether the renderer is rendering asynchronously (see `renderer_async`)
+extern bool rendererAsync_enabled;
+
 static inline void render(void)
 {
+   TRACE_BEGIN("render");
+   // the renderer paints the screen as it is now (when rendering
+   // asynchronously, the render thread paints a snapshot of it instead)
+   if (!rendererAsync_enabled) {
+      rendererScreen = screen;
+      rendererColors = screenColors;
+   }
+#if RENDERER_STATS
+   uint64_t start = rendererStats_clock();
+#endif
    // (unlikely is used as it doesn't matter if error "costs" more)
    if (unlikely( (*rendererSingleton.render)() ))
       rendererSingleton.error++;
+#if RENDERER_STATS
+   rendererStats_frame(start);
+#endif
+   TRACE_END("render");
 }
 
 static inline int renderer_getError(void)
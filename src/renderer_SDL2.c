@@ -2,16 +2,571 @@
 #if RENDERER_SDL2
 #include "renderer.h"
 #include "screen.h"
+#include "bitmap.h"
+#include "thread.h"
 
 // global state for a SDL2 renderer:
 static SDL_Window   *rendererSDL2_win  = NULL;
 static SDL_Renderer *rendererSDL2_rndr = NULL;
 static SDL_Texture  *rendererSDL2_tex  = NULL;
 
+// colors of the pixels (ARGB8888), see `rendererSDL2_setColors`
+// TODO: in future, we'll have "attributes" to determine the color
+static uint32_t      rendererSDL2_fg = RENDERER_SDL2_FG; // pixel on
+static uint32_t      rendererSDL2_bg = RENDERER_SDL2_BG; // pixel off
+
+// lookup table from a glyph line to its ARGB pixels
+static argbTable     rendererSDL2_argb;
+// scratch bitmap holding the scanlines of one row of glyphs
+static unsigned char rendererSDL2_bits[GLYPH_HEIGHT * GRID_WIDTH];
+
+// optional workers: the painting of the texture is split into bands of glyph
+// rows, one for each thread. Each band is painted into a disjoint slice of the
+// locked pixels, with its own scratch bitmap. (The thread calling `render()`
+// paints the first band, and the workers paint the other ones.)
+static struct {
+   int            count;     // number of threads painting (incl. the caller)
+   int            started;   // number of workers which have been started
+   thread         workers[RENDERER_SDL2_MAX_THREADS - 1];
+   unsigned char  bits[RENDERER_SDL2_MAX_THREADS - 1][GLYPH_HEIGHT * GRID_WIDTH];
+   mutex          lock;
+   condition      start;     // signaled when a new job is available
+   condition      done;      // signaled when the last band has been painted
+   unsigned       job;       // job counter
+   int            pending;   // number of workers that have yet to finish
+   bool           quit;      // workers should exit
+   // the job: paint [x0,x1[ x [y0,y1[ onto pixels
+   unsigned char *pixels;
+   int            pitch;
+   int            x0, y0, x1, y1;
+} rendererSDL2_pool;
+
+// shadow copy of the screen as it is on the texture: only the glyphs which
+// differ from it need to be painted again (unless the texture is invalid)
+static uint64_t      rendererSDL2_shadow[GRID_WIDTH * GRID_HEIGHT];
+static bool          rendererSDL2_invalid;
+// function painting an area of the screen (in glyphs) onto the texture
+static int         (*rendererSDL2_paintArea)(int x0, int y0, int x1, int y1);
+
+// RENDERER_SDL2_MODE_INDEX1: 1-bit surface with a two colors palette
+// (index 0: pixel off, index 1: pixel on)
+static SDL_Surface  *rendererSDL2_surface = NULL;
+
+
+// paint the glyph rows [y0,y1[ (of the area [x0,x1[ x [y0,y1[ in glyphs whose
+// texture pixels are locked at `pixels` with the given pitch) using the given
+// scratch bitmap, and update the shadow copy of the screen accordingly
+static void rendererSDL2_paintRows(unsigned char *bits,
+                                   unsigned char *pixels, int pitch,
+                                   int x0, int y0, int x1, int y1)
+{
+   // paint the glyphs onto the texture's pixels, one row of glyphs at a time:
+   // the glyphs are read once into a bitmap of GLYPH_HEIGHT scanlines (unless
+   // the bitmap of the screen is already made), then every scanline is
+   // expanded through the color lookup table.
+   int width = x1 - x0;
+   for (int y = y0; y < y1; y++) {
+       const uint64_t *glyphs = canvas_glyphPointer(rendererScreen, x0, y);
+       const unsigned char *row = bits;
+       int stride = width;
+       if (rendererBitmap) {
+          stride = rendererScreen.width;
+          row    = rendererBitmap + y * GLYPH_HEIGHT * stride + x0;
+       } else {
+          bitmap_fromGlyphRow(bits, width, glyphs, width);
+       }
+       SDL_memcpy(rendererSDL2_shadow + y * rendererScreen.width + x0, glyphs,
+                  width * sizeof(*glyphs));
+       for (int line = 0; line < GLYPH_HEIGHT; line++) {
+           bitmap_toARGB(&rendererSDL2_argb, row + line * stride,
+                         width, (uint32_t *)pixels);
+           pixels += pitch;
+       }
+   }
+}
+
+// the band of glyph rows of the current job painted by the thread `n`
+static void rendererSDL2_paintBand(unsigned char *bits, int n)
+{
+   int rows = rendererSDL2_pool.y1 - rendererSDL2_pool.y0;
+   int y0   = rendererSDL2_pool.y0 + rows *  n      / rendererSDL2_pool.count;
+   int y1   = rendererSDL2_pool.y0 + rows * (n + 1) / rendererSDL2_pool.count;
+   rendererSDL2_paintRows(bits, rendererSDL2_pool.pixels +
+                          (y0 - rendererSDL2_pool.y0) * GLYPH_HEIGHT * rendererSDL2_pool.pitch,
+                          rendererSDL2_pool.pitch,
+                          rendererSDL2_pool.x0, y0, rendererSDL2_pool.x1, y1);
+}
+
+// main function of the worker threads
+static int rendererSDL2_work(void *arg)
+{
+   int      n   = (int)(intptr_t)arg;
+   unsigned job = 0;
+
+   mutex_lock(&rendererSDL2_pool.lock);
+   for (;;) {
+      while (!rendererSDL2_pool.quit && rendererSDL2_pool.job == job)
+         condition_wait(&rendererSDL2_pool.start, &rendererSDL2_pool.lock);
+      if (rendererSDL2_pool.quit)
+         break;
+      job = rendererSDL2_pool.job;
+      mutex_unlock(&rendererSDL2_pool.lock);
+
+      rendererSDL2_paintBand(rendererSDL2_pool.bits[n - 1], n);
+
+      mutex_lock(&rendererSDL2_pool.lock);
+      if (--rendererSDL2_pool.pending == 0)
+         condition_signal(&rendererSDL2_pool.done);
+   }
+   mutex_unlock(&rendererSDL2_pool.lock);
+   return 0;
+}
+
+// stop and release the workers
+static void rendererSDL2_stopWorkers(void)
+{
+   if (rendererSDL2_pool.started == 0)
+      return;
+   mutex_lock(&rendererSDL2_pool.lock);
+   rendererSDL2_pool.quit = true;
+   condition_broadcast(&rendererSDL2_pool.start);
+   mutex_unlock(&rendererSDL2_pool.lock);
+   for (int i = 0; i < rendererSDL2_pool.started; i++)
+       thread_join(&rendererSDL2_pool.workers[i]);
+   condition_drop(&rendererSDL2_pool.done);
+   condition_drop(&rendererSDL2_pool.start);
+   mutex_drop(&rendererSDL2_pool.lock);
+   rendererSDL2_pool.started = 0;
+   rendererSDL2_pool.count   = 1;
+}
+
+// start the workers so that `threads` threads paint the texture
+// (if they can't be started, the caller will paint alone)
+static void rendererSDL2_startWorkers(int threads)
+{
+   rendererSDL2_pool.count   = 1;
+   rendererSDL2_pool.started = 0;
+   rendererSDL2_pool.quit    = false;
+   rendererSDL2_pool.job     = 0;
+   if (threads > RENDERER_SDL2_MAX_THREADS)  threads = RENDERER_SDL2_MAX_THREADS;
+   if (threads > rendererScreen.height)      threads = rendererScreen.height;
+   if (threads <= 1)
+      return;
+
+   if (mutex_init(&rendererSDL2_pool.lock))
+      return;
+   if (condition_init(&rendererSDL2_pool.start)) {
+      mutex_drop(&rendererSDL2_pool.lock);
+      return;
+   }
+   if (condition_init(&rendererSDL2_pool.done)) {
+      condition_drop(&rendererSDL2_pool.start);
+      mutex_drop(&rendererSDL2_pool.lock);
+      return;
+   }
+   while (rendererSDL2_pool.started < threads - 1 &&
+          !thread_create(&rendererSDL2_pool.workers[rendererSDL2_pool.started],
+                         &rendererSDL2_work,
+                         (void*)(intptr_t)(rendererSDL2_pool.started + 1)))
+      rendererSDL2_pool.started++;
+   if (rendererSDL2_pool.started == 0) {
+      condition_drop(&rendererSDL2_pool.done);
+      condition_drop(&rendererSDL2_pool.start);
+      mutex_drop(&rendererSDL2_pool.lock);
+      return;
+   }
+   rendererSDL2_pool.count = rendererSDL2_pool.started + 1;
+}
+
+// paint the glyphs of the screen in the area [x0,x1[ x [y0,y1[ (in glyphs)
+// onto the texture (and update the shadow copy of the screen accordingly)
+static int rendererSDL2_paint(int x0, int y0, int x1, int y1)
+{
+   // lock (only) that area of our texture to gain **write-only** access to
+   // its pixels. All those pixels *should* be written before unlocking the
+   // texture, otherwise they may have uninitialized value.
+   SDL_Rect  area = { .x = x0 * GLYPH_WIDTH,        .y = y0 * GLYPH_HEIGHT,
+                      .w = (x1 - x0) * GLYPH_WIDTH, .h = (y1 - y0) * GLYPH_HEIGHT };
+   int       pitch;
+   void     *pixel_data;
+   int err = SDL_LockTexture(rendererSDL2_tex, &area, &pixel_data, &pitch);
+   if (err)  return err;
+   assert(pixel_data != NULL);
+   assert(pitch >= (int)sizeof(uint32_t) * area.w);
+
+   if (rendererSDL2_pool.count > 1 && y1 - y0 >= rendererSDL2_pool.count) {
+      // hand out the bands to the workers, and paint the first one
+      mutex_lock(&rendererSDL2_pool.lock);
+      rendererSDL2_pool.pixels  = pixel_data;
+      rendererSDL2_pool.pitch   = pitch;
+      rendererSDL2_pool.x0      = x0;
+      rendererSDL2_pool.y0      = y0;
+      rendererSDL2_pool.x1      = x1;
+      rendererSDL2_pool.y1      = y1;
+      rendererSDL2_pool.pending = rendererSDL2_pool.started;
+      rendererSDL2_pool.job++;
+      condition_broadcast(&rendererSDL2_pool.start);
+      mutex_unlock(&rendererSDL2_pool.lock);
+
+      rendererSDL2_paintBand(rendererSDL2_bits, 0);
+
+      mutex_lock(&rendererSDL2_pool.lock);
+      while (rendererSDL2_pool.pending > 0)
+         condition_wait(&rendererSDL2_pool.done, &rendererSDL2_pool.lock);
+      mutex_unlock(&rendererSDL2_pool.lock);
+   } else {
+      rendererSDL2_paintRows(rendererSDL2_bits, pixel_data, pitch,
+                             x0, y0, x1, y1);
+   }
+
+   SDL_UnlockTexture(rendererSDL2_tex);
+   return 0;
+}
+
+// paint the glyph rows [y0,y1[ of the screen in RENDERER_SDL2_MODE_INDEX1:
+// the glyph lines are written as-is in the 1-bit paletted surface, and SDL
+// expands them through the palette when blitting onto the texture.
+// (x0 and x1 are ignored: SDL may not blit a 1-bit surface from an x offset,
+//  so whole rows are painted, which is anyway cheap with 1 bit per pixel)
+static int rendererSDL2_paintIndex1(int x0, int y0, int x1, int y1)
+{  (void)x0; (void)x1;
+   SDL_Surface *surface = rendererSDL2_surface;
+   for (int y = y0; y < y1; y++) {
+       const uint64_t *glyphs = canvas_glyphPointer(rendererScreen, 0, y);
+       unsigned char  *lines  = (unsigned char *)surface->pixels +
+                                y * GLYPH_HEIGHT * surface->pitch;
+       if (rendererBitmap) {
+          for (int line = 0; line < GLYPH_HEIGHT; line++)
+              SDL_memcpy(lines + line * surface->pitch,
+                         rendererBitmap + (y * GLYPH_HEIGHT + line) * rendererScreen.width,
+                         rendererScreen.width);
+       } else {
+          bitmap_fromGlyphRow(lines, surface->pitch, glyphs, rendererScreen.width);
+       }
+       SDL_memcpy(rendererSDL2_shadow + y * rendererScreen.width, glyphs,
+                  rendererScreen.width * sizeof(*glyphs));
+   }
+
+   // lock that area of the texture, and let SDL blit the surface onto it
+   SDL_Rect  area = { .x = 0,  .w = rendererScreen.width * GLYPH_WIDTH,
+                      .y = y0 * GLYPH_HEIGHT,  .h = (y1 - y0) * GLYPH_HEIGHT };
+   int       pitch;
+   void     *pixel_data;
+   int err = SDL_LockTexture(rendererSDL2_tex, &area, &pixel_data, &pitch);
+   if (err)  return err;
+   SDL_Surface *target = SDL_CreateRGBSurfaceWithFormatFrom(pixel_data,
+                            area.w, area.h, 32, pitch, SDL_PIXELFORMAT_ARGB8888);
+   if (target == NULL) {
+      SDL_UnlockTexture(rendererSDL2_tex);
+      return -1;
+   }
+   err = SDL_BlitSurface(surface, &area, target, NULL);
+   SDL_FreeSurface(target);
+   SDL_UnlockTexture(rendererSDL2_tex);
+   return err;
+}
+
+// compare the row `y` of the screen with its shadow copy
+// return true iff it has changed, then [*x0, *x1[ is the span of the changes.
+static bool rendererSDL2_diffRow(int y, int *x0, int *x1)
+{
+   const uint64_t *row    = canvas_glyphPointer(rendererScreen, 0, y);
+   const uint64_t *shadow = rendererSDL2_shadow + y * rendererScreen.width;
+
+   int x = 0;
+   while (x < rendererScreen.width && row[x] == shadow[x])  x++;
+   if (x == rendererScreen.width)
+      return false;
+   *x0 = x;
+
+   x = rendererScreen.width;
+   while (row[x - 1] == shadow[x - 1])  x--;
+   *x1 = x;
+   return true;
+}
+
+//===< tiles mode >=============================================================
+// Each distinct glyph on the screen is cached as a 8x8 tile in an atlas texture
+// and the whole screen is drawn as one batch of textured quads (one per glyph).
+// The atlas has one tile per glyph of the screen, so a frame can always show
+// all its glyphs: when a glyph isn't cached, it replaces the least recently
+// used tile, which cannot be one of the tiles already used by the frame.
+#if SDL_VERSION_ATLEAST(2,0,18) // <-- SDL_RenderGeometry
+#   define RENDERER_SDL2_HAS_TILES  1
+
+static struct {
+   SDL_Texture *atlas;
+   int          columns;     // width of the atlas (in tiles)
+   int          capacity;    // number of tiles
+   uint64_t    *glyph;       // glyph cached in each tile
+   int         *prev;        // LRU list of the tiles, from the most recently
+   int         *next;        //     used (head) to the least recently used (tail)
+   int          head, tail;
+   int         *table;       // hash table (linear probing): glyph -> tile or -1
+   unsigned     mask;        // size of the hash table - 1 (power of two)
+   int          bits;        // log2 of the size of the hash table
+   int         *cell;        // tile used by each glyph of the screen (or -1)
+   SDL_Vertex  *vertices;    // 4 vertices for each glyph of the screen
+   int         *indices;     // 6 indices for each glyph of the screen
+} rendererSDL2_tiles;
+
+// index of a glyph in the hash table (Fibonacci hashing)
+static inline unsigned rendererSDL2_tileHash(uint64_t glyph)
+{ return (unsigned)((glyph * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - rendererSDL2_tiles.bits)); }
+
+// return the position in the hash table which holds the glyph,
+// or the empty position where it would be inserted
+static inline unsigned rendererSDL2_tileFind(uint64_t glyph)
+{
+   unsigned i = rendererSDL2_tileHash(glyph);
+   int t;
+   while ((t = rendererSDL2_tiles.table[i]) >= 0 && rendererSDL2_tiles.glyph[t] != glyph)
+      i = (i + 1) & rendererSDL2_tiles.mask;
+   return i;
+}
+
+// remove the entry at position i of the hash table
+// (backward shift deletion: move back the entries of the cluster which follow)
+static void rendererSDL2_tileRemove(unsigned i)
+{
+   unsigned mask = rendererSDL2_tiles.mask;
+   for (unsigned j = (i + 1) & mask; rendererSDL2_tiles.table[j] >= 0; j = (j + 1) & mask) {
+       unsigned home = rendererSDL2_tileHash(rendererSDL2_tiles.glyph[rendererSDL2_tiles.table[j]]);
+       // move the entry at j if its home position isn't cyclically in ]i,j]
+       if (((j - home) & mask) >= ((j - i) & mask)) {
+          rendererSDL2_tiles.table[i] = rendererSDL2_tiles.table[j];
+          i = j;
+       }
+   }
+   rendererSDL2_tiles.table[i] = -1;
+}
+
+// move the tile t at the head of the LRU list
+static inline void rendererSDL2_tileTouch(int t)
+{
+   if (t == rendererSDL2_tiles.head)
+      return;
+   // unlink
+   int prev = rendererSDL2_tiles.prev[t], next = rendererSDL2_tiles.next[t];
+   rendererSDL2_tiles.next[prev] = next;
+   if (next >= 0)  rendererSDL2_tiles.prev[next] = prev;
+   else            rendererSDL2_tiles.tail = prev;
+   // push front
+   rendererSDL2_tiles.prev[t] = -1;
+   rendererSDL2_tiles.next[t] = rendererSDL2_tiles.head;
+   rendererSDL2_tiles.prev[rendererSDL2_tiles.head] = t;
+   rendererSDL2_tiles.head = t;
+}
+
+// return the tile caching the given glyph (uploading it if needed)
+static int rendererSDL2_tile(uint64_t glyph)
+{
+   unsigned i = rendererSDL2_tileFind(glyph);
+   int t = rendererSDL2_tiles.table[i];
+   if (t >= 0) {
+      rendererSDL2_tileTouch(t);
+      return t;
+   }
+
+   // evict the least recently used tile (if it holds a glyph)
+   t = rendererSDL2_tiles.tail;
+   unsigned old = rendererSDL2_tileFind(rendererSDL2_tiles.glyph[t]);
+   if (rendererSDL2_tiles.table[old] == t) {
+      rendererSDL2_tileRemove(old);
+      i = rendererSDL2_tileFind(glyph); // <-- the cluster may have moved
+   }
+   rendererSDL2_tiles.glyph[t] = glyph;
+   rendererSDL2_tiles.table[i] = t;
+   rendererSDL2_tileTouch(t);
+
+   // upload the glyph pixels in the tile
+   uint32_t pixels[GLYPH_HEIGHT][GLYPH_WIDTH];
+   unsigned char bits[GLYPH_HEIGHT];
+   bitmap_fromGlyphRow(bits, 1, &glyph, 1);
+   for (int line = 0; line < GLYPH_HEIGHT; line++)
+       bitmap_toARGB(&rendererSDL2_argb, bits + line, 1, pixels[line]);
+   SDL_Rect area = { .x = (t % rendererSDL2_tiles.columns) * GLYPH_WIDTH,
+                     .y = (t / rendererSDL2_tiles.columns) * GLYPH_HEIGHT,
+                     .w = GLYPH_WIDTH, .h = GLYPH_HEIGHT };
+   SDL_UpdateTexture(rendererSDL2_tiles.atlas, &area, pixels, sizeof(pixels[0]));
+   return t;
+}
+
+// render function in tiles mode
+static int rendererSDL2_renderTiles(void)
+{
+   TRACE_BEGIN("rendererSDL2_renderTiles");
+   float tile_w = 1.0f / rendererSDL2_tiles.columns; // size of a tile in
+   float tile_h = 1.0f / rendererSDL2_tiles.columns; // texture coordinates
+
+   SDL_Vertex *v = rendererSDL2_tiles.vertices;
+   int        *c = rendererSDL2_tiles.cell;
+   for (int y = 0; y < rendererScreen.height; y++) {
+       const uint64_t *glyphs = canvas_glyphPointer(rendererScreen, 0, y);
+       for (int x = 0; x < rendererScreen.width; x++, c++, v += 4) {
+           // the tile of the last frame is still valid for an unchanged glyph
+           if (*c >= 0 && rendererSDL2_tiles.glyph[*c] == glyphs[x]) {
+              rendererSDL2_tileTouch(*c);
+              continue;
+           }
+           int t = *c = rendererSDL2_tile(glyphs[x]);
+           float u0 = (t % rendererSDL2_tiles.columns) * tile_w, u1 = u0 + tile_w;
+           float v0 = (t / rendererSDL2_tiles.columns) * tile_h, v1 = v0 + tile_h;
+           v[0].tex_coord = (SDL_FPoint){ u0, v0 };
+           v[1].tex_coord = (SDL_FPoint){ u1, v0 };
+           v[2].tex_coord = (SDL_FPoint){ u1, v1 };
+           v[3].tex_coord = (SDL_FPoint){ u0, v1 };
+       }
+   }
+
+   int cells = rendererScreen.width * rendererScreen.height;
+   uint64_t start = rendererStats_clock();
+   int err = SDL_RenderGeometry(rendererSDL2_rndr, rendererSDL2_tiles.atlas,
+                                rendererSDL2_tiles.vertices, 4 * cells,
+                                rendererSDL2_tiles.indices,  6 * cells);
+   if (!err) {
+      SDL_RenderPresent(rendererSDL2_rndr);
+      rendererStats_present(start, 0);
+   }
+   TRACE_END("rendererSDL2_renderTiles");
+   return err;
+}
+
+// release the resources of the tiles mode
+static void rendererSDL2_dropTiles(void)
+{
+   if (rendererSDL2_tiles.atlas)
+      SDL_DestroyTexture(rendererSDL2_tiles.atlas);
+   SDL_free(rendererSDL2_tiles.glyph);
+   SDL_free(rendererSDL2_tiles.prev);
+   SDL_free(rendererSDL2_tiles.next);
+   SDL_free(rendererSDL2_tiles.table);
+   SDL_free(rendererSDL2_tiles.cell);
+   SDL_free(rendererSDL2_tiles.vertices);
+   SDL_free(rendererSDL2_tiles.indices);
+   SDL_memset(&rendererSDL2_tiles, 0, sizeof(rendererSDL2_tiles));
+}
+
+// initialize the tiles mode: return 0 iff successful
+static int rendererSDL2_initTiles(void)
+{
+   int cells = rendererScreen.width * rendererScreen.height;
+   int columns = 1;
+   while (columns * columns < cells)  columns++;
+   int bits = 1;
+   while ((1 << bits) < 2 * cells)     bits++;
+
+   rendererSDL2_tiles.columns  = columns;
+   rendererSDL2_tiles.capacity = cells;
+   rendererSDL2_tiles.bits     = bits;
+   rendererSDL2_tiles.mask     = (1u << bits) - 1;
+   rendererSDL2_tiles.glyph    = SDL_calloc(cells, sizeof(uint64_t));
+   rendererSDL2_tiles.prev     = SDL_malloc(cells * sizeof(int));
+   rendererSDL2_tiles.next     = SDL_malloc(cells * sizeof(int));
+   rendererSDL2_tiles.table    = SDL_malloc((1u << bits) * sizeof(int));
+   rendererSDL2_tiles.cell     = SDL_malloc(cells * sizeof(int));
+   rendererSDL2_tiles.vertices = SDL_malloc(4 * cells * sizeof(SDL_Vertex));
+   rendererSDL2_tiles.indices  = SDL_malloc(6 * cells * sizeof(int));
+   rendererSDL2_tiles.atlas    = SDL_CreateTexture(rendererSDL2_rndr,
+                                    SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STATIC,
+                                    columns * GLYPH_WIDTH, columns * GLYPH_HEIGHT);
+   if (!rendererSDL2_tiles.glyph || !rendererSDL2_tiles.prev  ||
+       !rendererSDL2_tiles.next  || !rendererSDL2_tiles.table ||
+       !rendererSDL2_tiles.cell  || !rendererSDL2_tiles.vertices ||
+       !rendererSDL2_tiles.indices || !rendererSDL2_tiles.atlas) {
+      rendererSDL2_dropTiles();
+      return -1;
+   }
+
+   // empty cache: all tiles in the LRU list, but none in the hash table
+   for (int t = 0; t < cells; t++) {
+       rendererSDL2_tiles.prev[t] = t - 1;
+       rendererSDL2_tiles.next[t] = (t + 1 < cells) ? t + 1 : -1;
+       rendererSDL2_tiles.cell[t] = -1;
+   }
+   rendererSDL2_tiles.head = 0;
+   rendererSDL2_tiles.tail = cells - 1;
+   SDL_memset(rendererSDL2_tiles.table, -1, (1u << bits) * sizeof(int));
+
+   // the quads are fixed: two triangles per glyph, scaled to the window
+   int out_w, out_h;
+   if (SDL_GetRendererOutputSize(rendererSDL2_rndr, &out_w, &out_h)) {
+      rendererSDL2_dropTiles();
+      return -1;
+   }
+   float w = (float)out_w / rendererScreen.width;
+   float h = (float)out_h / rendererScreen.height;
+   SDL_Vertex *v = rendererSDL2_tiles.vertices;
+   int        *i = rendererSDL2_tiles.indices;
+   for (int y = 0; y < rendererScreen.height; y++) {
+       for (int x = 0; x < rendererScreen.width; x++, v += 4, i += 6) {
+           int n = v - rendererSDL2_tiles.vertices;
+           v[0].position = (SDL_FPoint){  x      * w,  y      * h };
+           v[1].position = (SDL_FPoint){ (x + 1) * w,  y      * h };
+           v[2].position = (SDL_FPoint){ (x + 1) * w, (y + 1) * h };
+           v[3].position = (SDL_FPoint){  x      * w, (y + 1) * h };
+           for (int k = 0; k < 4; k++)
+               v[k].color = (SDL_Color){ 0xff, 0xff, 0xff, 0xff };
+           i[0] = n;  i[1] = n + 1;  i[2] = n + 2;
+           i[3] = n;  i[4] = n + 2;  i[5] = n + 3;
+       }
+   }
+   return 0;
+}
+
+#else
+#   define RENDERER_SDL2_HAS_TILES  0
+#endif
+//===</ tiles mode >============================================================
+
+
+// set the palette of the 1-bit surface from the current colors
+static int rendererSDL2_setPalette(void)
+{
+   SDL_Color colors[2] = {
+      { .r = rendererSDL2_bg >> 16 & 0xff, .g = rendererSDL2_bg >> 8 & 0xff,
+        .b = rendererSDL2_bg       & 0xff, .a = 0xff },
+      { .r = rendererSDL2_fg >> 16 & 0xff, .g = rendererSDL2_fg >> 8 & 0xff,
+        .b = rendererSDL2_fg       & 0xff, .a = 0xff },
+   };
+   return SDL_SetPaletteColors(rendererSDL2_surface->format->palette, colors, 0, 2);
+}
+
+int rendererSDL2_setColors(uint32_t fg, uint32_t bg)
+{
+   rendererSDL2_fg = fg & UINT32_C(0xffffff);
+   rendererSDL2_bg = bg & UINT32_C(0xffffff);
+   argbTable_init(&rendererSDL2_argb, rendererSDL2_fg, rendererSDL2_bg);
+   if (rendererSDL2_win == NULL) // (not initialized, even as a FanOut sink)
+      return 0;
+
+   // the pixels already painted must be painted again:
+   rendererSDL2_invalid = true;
+#if RENDERER_SDL2_HAS_TILES
+   if (rendererSDL2_tiles.atlas) { // empty the tiles cache
+      SDL_memset(rendererSDL2_tiles.table, -1,
+                 (rendererSDL2_tiles.mask + 1) * sizeof(int));
+      SDL_memset(rendererSDL2_tiles.cell, -1,
+                 rendererSDL2_tiles.capacity * sizeof(int));
+   }
+#endif
+   if (rendererSDL2_surface)
+      return rendererSDL2_setPalette();
+   return 0;
+}
 
 // SDL2 renderer drop function
 static int rendererSDL2_drop(void)
 {
+   rendererSDL2_stopWorkers();
+#if RENDERER_SDL2_HAS_TILES
+   rendererSDL2_dropTiles();
+#endif
+   if (rendererSDL2_surface) {
+      SDL_FreeSurface(rendererSDL2_surface);
+      rendererSDL2_surface = NULL;
+   }
    if (rendererSDL2_tex) {
       SDL_DestroyTexture(rendererSDL2_tex);
       rendererSDL2_tex  = NULL;
@@ -20,7 +575,7 @@ static int rendererSDL2_drop(void)
       SDL_DestroyRenderer(rendererSDL2_rndr);
       rendererSDL2_rndr = NULL;
    }
-   if (rendererSDL2_rndr) {
+   if (rendererSDL2_win) {
       SDL_DestroyWindow(rendererSDL2_win);
       rendererSDL2_win  = NULL;
    }
@@ -31,50 +586,56 @@ static int rendererSDL2_drop(void)
 // SDL2 render function
 static int rendererSDL2_render(void)
 {
-   // lock our texture to gain **write-only** access to its pixels
-   // all pixels *should* be written before unlocking the texture,
-   // otherwise they may have uninitialized value.
-   int       pitch;
-   void     *pixel_data;
-   SDL_LockTexture(rendererSDL2_tex, NULL, &pixel_data, &pitch);
-   uint32_t *pixels = pixel_data;
-   assert(pixels != NULL);
-   assert(pitch == (sizeof(*pixels) * screen.width * GLYPH_WIDTH));
-
-   // paint the canvas onto the texture's pixels
-   for (int y = 0; y < GLYPH_HEIGHT * screen.height; y++) {
-       for (int x = 0; x < screen.width; x++) {
-           uint64_t glyph = canvas_glyph(screen, x, y / GLYPH_HEIGHT);
-           unsigned char line = glyph_line(glyph, y % GLYPH_HEIGHT);
-
-           for (int i = (GLYPH_WIDTH - 1); i >= 0; i--) {
-               // TODO/FIXME: maybe endianess could cause us issues
-               //             also pushing uint32_t ???, naaah prob. fine
-               //             or should it be bytes (unsigned char) instead
-               //             or we should use SDL_MapRGB or something?
-               // TODO:
-               //       also in future, we'll have "attributes" here to
-               //       determine the color
-               if (line & (1 << i)) {
-                  *pixels = UINT32_C(0x00cccc00); // pixel on
-               } else {
-                  *pixels = UINT32_C(0x00000080); // pixel off
-               }
-               pixels++;
-           }
-       }
+   int err;
+   TRACE_BEGIN("rendererSDL2_render");
+
+   if (rendererSDL2_invalid) {
+      // paint everything
+      err = (*rendererSDL2_paintArea)(0, 0, rendererScreen.width,
+                                            rendererScreen.height);
+      if (err)  goto end;
+      rendererSDL2_invalid = false;
+   } else {
+      // only paint the glyphs which have changed since the last frame:
+      // consecutive changed rows are merged into one rectangle, which spans
+      // all their changes.
+      int y = 0, x0, x1;
+      while (y < rendererScreen.height) {
+         if (!rendererSDL2_diffRow(y, &x0, &x1)) {
+            y++;
+            continue;
+         }
+         int y0 = y++, dx0, dx1;
+         for (; y < rendererScreen.height && rendererSDL2_diffRow(y, &dx0, &dx1); y++) {
+            if (dx0 < x0)  x0 = dx0;
+            if (dx1 > x1)  x1 = dx1;
+         }
+         err = (*rendererSDL2_paintArea)(x0, y0, x1, y);
+         if (err)  goto end;
+      }
    }
 
-   // now release (unlock) the texture and render it
-   SDL_UnlockTexture(rendererSDL2_tex);
-   int err = SDL_RenderCopy(rendererSDL2_rndr, rendererSDL2_tex, NULL, NULL);
-   if (err)  return err;
+   // now render the texture
+   uint64_t start = rendererStats_clock();
+   err = SDL_RenderCopy(rendererSDL2_rndr, rendererSDL2_tex, NULL, NULL);
+   if (err)  goto end;
    SDL_RenderPresent(rendererSDL2_rndr);
-   return 0;
+   rendererStats_present(start, 0);
+
+end:
+   TRACE_END("rendererSDL2_render");
+   return err;
 }
 
 int rendererSDL2_init(const char* title, int win_width, int win_height)
+{ return rendererSDL2_initWithOptions(title, win_width, win_height, NULL); }
+
+int rendererSDL2_initWithOptions(const char* title, int win_width, int win_height,
+                                 const rendererSDL2Options *options)
 {
+   static const rendererSDL2Options defaults = {0};
+   if (options == NULL)  options = &defaults;
+
    // drop the active renderer
    renderer_drop();
    rendererSingleton.error = 0;
@@ -102,22 +663,53 @@ int rendererSDL2_init(const char* title, int win_width, int win_height)
    if (rendererSDL2_win == NULL)  { ret = -1; goto error_window; }
 
    // create SDL renderer
-   rendererSDL2_rndr = SDL_CreateRenderer(rendererSDL2_win, -1,
-                            0); // TODO:   SDL_RENDERER_ACCELERATED???
-                                //       | SDL_RENDERER_PRESENTVSYNC
+   Uint32 rndr_flags = ((options->software)? SDL_RENDERER_SOFTWARE     : 0)
+                     | ((options->vsync)   ? SDL_RENDERER_PRESENTVSYNC : 0);
+                       // TODO:   SDL_RENDERER_ACCELERATED???
+   rendererSDL2_rndr = SDL_CreateRenderer(rendererSDL2_win, -1, rndr_flags);
    if (rendererSDL2_rndr == NULL)  { ret = -1; goto error_renderer; }
+   argbTable_init(&rendererSDL2_argb, rendererSDL2_fg, rendererSDL2_bg);
 
-   // create a single SDL_Texture for painting the whole screen onto.
-   rendererSDL2_tex = SDL_CreateTexture(rendererSDL2_rndr,
-                           SDL_PIXELFORMAT_ARGB8888,
-                           SDL_TEXTUREACCESS_STREAMING,
-                           screen.width  * GLYPH_WIDTH,
-                           screen.height * GLYPH_HEIGHT);
-   if (rendererSDL2_tex == NULL)   { ret = -1; goto error_texture; }
+   int (*render_function)(void) = &rendererSDL2_render;
+#if RENDERER_SDL2_HAS_TILES
+   if (options->mode == RENDERER_SDL2_MODE_TILES) {
+      // create the atlas of tiles (and the geometry to draw them)
+      if (rendererSDL2_initTiles())  { ret = -1; goto error_texture; }
+      render_function = &rendererSDL2_renderTiles;
+   } else
+#endif
+   {
+      // create a single SDL_Texture for painting the whole screen onto.
+      rendererSDL2_tex = SDL_CreateTexture(rendererSDL2_rndr,
+                              SDL_PIXELFORMAT_ARGB8888,
+                              SDL_TEXTUREACCESS_STREAMING,
+                              rendererScreen.width  * GLYPH_WIDTH,
+                              rendererScreen.height * GLYPH_HEIGHT);
+      if (rendererSDL2_tex == NULL)   { ret = -1; goto error_texture; }
+      rendererSDL2_invalid   = true;
+      rendererSDL2_paintArea = &rendererSDL2_paint;
+
+      if (options->mode == RENDERER_SDL2_MODE_INDEX1) {
+         // with the 1-bit surface that SDL expands through its palette
+         rendererSDL2_surface = SDL_CreateRGBSurfaceWithFormat(0,
+                                   rendererScreen.width  * GLYPH_WIDTH,
+                                   rendererScreen.height * GLYPH_HEIGHT,
+                                   1, SDL_PIXELFORMAT_INDEX1MSB);
+         if (rendererSDL2_surface == NULL) {
+            SDL_DestroyTexture(rendererSDL2_tex);
+            rendererSDL2_tex = NULL;
+            ret = -1; goto error_texture;
+         }
+         rendererSDL2_setPalette();
+         rendererSDL2_paintArea = &rendererSDL2_paintIndex1;
+      } else {
+         rendererSDL2_startWorkers(options->threads);
+      }
+   }
 
    // set the active render (and render() once, otherwise window is empty)
    rendererSingleton.id     = RENDERER_SDL2;
-   rendererSingleton.render = &rendererSDL2_render;
+   rendererSingleton.render = render_function;
    rendererSingleton.drop   = &rendererSDL2_drop;
 
    // TODO: to complete the initialization, we may wish to do
@@ -128,8 +720,10 @@ int rendererSDL2_init(const char* title, int win_width, int win_height)
 // error handling:
 error_texture:
    SDL_DestroyRenderer(rendererSDL2_rndr);
+   rendererSDL2_rndr = NULL;
 error_renderer:
    SDL_DestroyWindow(rendererSDL2_win);
+   rendererSDL2_win  = NULL;
 error_window:
    SDL_QuitSubSystem(SDL_INIT_VIDEO);
 error_init:
@@ -26,9 +26,72 @@
 /// * of it error value is >0, then its is an internal error.
 int rendererSDL2_init(const char* title, int win_width, int win_height);
 
+/// @brief how the SDL2 renderer draws the screen
+typedef enum rendererSDL2Mode {
+   RENDERER_SDL2_MODE_TEXTURE, ///< the pixels of the screen are painted onto
+                               ///< a single "STREAMING" texture (default)
+   RENDERER_SDL2_MODE_TILES,   ///< each distinct glyph is cached as a tile in
+                               ///< an atlas texture, and the screen is drawn
+                               ///< as one batch of textured quads. (requires
+                               ///< SDL 2.0.18, otherwise uses the default mode)
+   RENDERER_SDL2_MODE_INDEX1,  ///< the screen is written as-is into a 1-bit
+                               ///< paletted surface (SDL_PIXELFORMAT_INDEX1MSB)
+                               ///< and SDL expands it through its two colors
+                               ///< palette onto the texture, then scales it.
+} rendererSDL2Mode;
+
+/// @brief options of the SDL2 renderer
+/// (a zero-initialized struct gives the default options)
+typedef struct rendererSDL2Options {
+   rendererSDL2Mode mode; ///< how to draw the screen
+   bool software;         ///< use SDL's software renderer. (Together with the
+                          ///< "dummy" SDL video driver, ie: environment
+                          ///< variable SDL_VIDEODRIVER=dummy, this allows to
+                          ///< run without any display)
+   bool vsync;            ///< synchronize presenting the screen with the
+                          ///< refresh of the display, ie: `render()` waits
+                          ///< for the next refresh. (then, frames are paced
+                          ///< by the display rather than by `frame_end()`)
+   int threads;           ///< number of threads painting the screen onto the
+                          ///< texture, including the thread calling `render()`
+                          ///< (<= 1: no extra threads, and at most
+                          ///<        RENDERER_SDL2_MAX_THREADS)
+                          ///< (only used in RENDERER_SDL2_MODE_TEXTURE)
+} rendererSDL2Options;
+
+/// @brief set the colors of the SDL2 renderer
+/// @param fg color (0xRRGGBB) of the pixels which are set
+/// @param bg color (0xRRGGBB) of the pixels which are unset
+/// @return 0 iff successful
+/// @details The colors are kept for the next initializations of the renderer.
+///          When the SDL2 renderer is active, the next `render()` repaints
+///          the screen with the new colors.
+int rendererSDL2_setColors(uint32_t fg, uint32_t bg);
+
+/// @brief default colors (0xRRGGBB) of the SDL2 renderer
+#ifndef    RENDERER_SDL2_FG
+#   define RENDERER_SDL2_FG  UINT32_C(0xcccc00)
+#endif
+#ifndef    RENDERER_SDL2_BG
+#   define RENDERER_SDL2_BG  UINT32_C(0x000080)
+#endif
+
+/// @brief maximum number of threads painting the texture
+#ifndef    RENDERER_SDL2_MAX_THREADS
+#   define RENDERER_SDL2_MAX_THREADS  16
+#endif
+
+/// @brief initialize a graphical renderer using SDL2 with the given options
+/// @param options the options (or NULL for the default options)
+/// @details see `rendererSDL2_init` for the other parameters and return value.
+int rendererSDL2_initWithOptions(const char* title, int win_width, int win_height,
+                                 const rendererSDL2Options *options);
+
 #else
 #   define RENDERER_SDL2                   0
 #   define rendererSDL2_init(title, w, h)  1
+#   define rendererSDL2_initWithOptions(title, w, h, options)  1
+#   define rendererSDL2_setColors(fg, bg)  1
 
 #endif //KONPU_PLATFORM_SDL2
 #endif //KONPU_RENDERER_SDL2_H
@@ -0,0 +1,112 @@
+#include "renderer_fanout.h"
+#include "renderer.h"
+#include "screen.h"
+#include "bitmap.h"
+
+// the sinks (their `error` field counts the frames they couldn't render)
+static struct rendererObject rendererFanOut_sinks[RENDERER_FANOUT_MAX_SINKS];
+static int                   rendererFanOut_sinkCount;
+
+// bitmap of the screen shared by the sinks (with GLYPH_HEIGHT more lines)
+static unsigned char rendererFanOut_bits[GLYPH_HEIGHT * (GRID_HEIGHT + 1) * GRID_WIDTH];
+
+
+// `render` function for the FanOut renderer
+static int
+rendererFanOut_render(void)
+{  CANVAS_ASSERT(rendererScreen);
+   assert(rendererScreen.width <= GRID_WIDTH && rendererScreen.height <= GRID_HEIGHT);
+
+   TRACE_BEGIN("rendererFanOut_render");
+
+   // convert the screen once, for all the sinks
+   int pitch = rendererScreen.width;
+   int lines = GLYPH_HEIGHT * rendererScreen.height;
+   for (int y = 0; y < rendererScreen.height; y++)
+       bitmap_fromCanvasRow(rendererFanOut_bits + y * GLYPH_HEIGHT * pitch,
+                            pitch, rendererScreen, y);
+   for (int i = lines * pitch; i < (lines + GLYPH_HEIGHT) * pitch; i++)
+       rendererFanOut_bits[i] = 0;
+
+   int err = 0;
+   rendererBitmap = rendererFanOut_bits;
+   for (int i = 0; i < rendererFanOut_sinkCount; i++) {
+       struct rendererObject *sink = rendererFanOut_sinks + i;
+       if (unlikely( (*sink->render)() )) {
+          sink->error++;
+          err = -1;
+       }
+   }
+   rendererBitmap = NULL;
+   TRACE_END("rendererFanOut_render");
+   return err;
+}
+
+// `drop` function for the FanOut renderer: drop all the sinks
+// (it returns the first error returned by their drop function)
+static int
+rendererFanOut_drop(void)
+{
+   int err = 0;
+   for (int i = 0; i < rendererFanOut_sinkCount; i++) {
+       int sink_err = (*rendererFanOut_sinks[i].drop)();
+       if (err == 0)   err = sink_err;
+   }
+   rendererFanOut_sinkCount = 0;
+   return err;
+}
+
+int rendererFanOut_add(void)
+{
+   if (rendererSingleton.id == RENDERER_NULL   ||
+       rendererSingleton.id == RENDERER_FANOUT ||
+       rendererFanOut_sinkCount == RENDERER_FANOUT_MAX_SINKS)
+      return -1;
+
+   // take the active renderer (with a fresh error count) and replace it by
+   // the Null renderer, without dropping it
+   struct rendererObject *sink = rendererFanOut_sinks + rendererFanOut_sinkCount++;
+   *sink = rendererSingleton;
+   sink->error = 0;
+   rendererSingleton.id     = RENDERER_NULL;
+   rendererSingleton.render = &renderer_null;
+   rendererSingleton.drop   = &renderer_null;
+   rendererSingleton.error  = 0;
+   return 0;
+}
+
+int rendererFanOut_init(void)
+{
+   // drop the active renderer (we can't do error checking)
+   // (if it's the FanOut renderer, this drops its sinks)
+   renderer_drop();
+   rendererSingleton.error = 0;
+   if (rendererFanOut_sinkCount == 0)
+      return -1;
+
+   // set the active render
+   rendererSingleton.id     = RENDERER_FANOUT;
+   rendererSingleton.render = &rendererFanOut_render;
+   rendererSingleton.drop   = &rendererFanOut_drop;
+   return 0;
+}
+
+int rendererFanOut_count(void)
+{
+   return rendererFanOut_sinkCount;
+}
+
+int rendererFanOut_find(int id)
+{
+   for (int i = 0; i < rendererFanOut_sinkCount; i++)
+       if (rendererFanOut_sinks[i].id == id)
+          return i;
+   return -1;
+}
+
+int rendererFanOut_getError(int sink)
+{
+   if (sink < 0 || sink >= rendererFanOut_sinkCount)
+      return -1;
+   return (int)rendererFanOut_sinks[sink].error;
+}
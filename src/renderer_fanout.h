@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * @file
+ * The FanOut renderer paints the screen with several renderers at once (its
+ * "sinks"), for example on a SDL2 window while recording a Y4M video.
+ *
+ * Every frame, it converts the screen into a bitmap once (see `rendererBitmap`)
+ * which the sinks using bitmaps (the PPM, Y4M, PseudoGraphics renderers and
+ * the SDL2 renderer when it paints pixels) take instead of doing their own
+ * conversion. It also counts the errors of each sink.
+ *
+ * Usage: initialize each sink as usual, and add it to the FanOut renderer just
+ * after, then initialize the FanOut renderer, ie:
+ *    rendererSDL2_init("my game", 768, 432);   rendererFanOut_add();
+ *    rendererY4M_init(60, 1, 1);                rendererFanOut_add();
+ *    rendererFanOut_init();
+ * (as the sinks are builtin renderers, each of them may only be used once)
+ ******************************************************************************/
+#ifndef  KONPU_RENDERER_FANOUT_H
+#define  KONPU_RENDERER_FANOUT_H
+#include "platform.h"
+#include "c.h"
+
+/// @brief RENDERER_FANOUT is set to a non-zero value if the FanOut renderer is
+///        available (it always is).
+#define RENDERER_FANOUT             6
+
+/// @brief RENDERER_FANOUT_MAX_SINKS settings:
+/// maximum number of sinks of the FanOut renderer
+#ifndef    RENDERER_FANOUT_MAX_SINKS
+#   define RENDERER_FANOUT_MAX_SINKS  8
+#endif
+
+/// @brief  add the active renderer to the sinks of the FanOut renderer
+/// @return 0 iff successful. It fails if there's no active renderer (or if it's
+///         the FanOut renderer itself) or if there are too many sinks.
+/// @details The active renderer is then the Null renderer (the added renderer
+///          isn't dropped), so that the next sink may be initialized.
+int rendererFanOut_add(void);
+
+/// @brief  initialize the FanOut renderer with the sinks which have been added
+/// @return 0 iff initialization is successful (it fails if there's no sink)
+/// @details The FanOut renderer drops all its sinks when it's dropped.
+///          The error count of the renderer (see `renderer_getError`) is the
+///          number of frames where any of the sinks failed.
+int rendererFanOut_init(void);
+
+/// @brief  return the number of sinks (which have been added)
+int rendererFanOut_count(void);
+
+/// @brief  find the sink which is a given renderer
+/// @param  id id of the renderer (for example: RENDERER_SDL2)
+/// @return index of the sink (in the order they were added), or -1 if no sink
+///         is that renderer
+int rendererFanOut_find(int id);
+
+/// @brief  return the error count of a sink (see `renderer_getError`)
+/// @param  sink index of the sink (in the order they were added)
+/// @return the number of frames which this sink couldn't render (or -1 if
+///         there's no such sink)
+int rendererFanOut_getError(int sink);
+
+#endif //KONPU_RENDERER_FANOUT_H
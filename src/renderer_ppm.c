@@ -2,11 +2,17 @@
 #if RENDERER_PPM
 #include "renderer.h"
 #include "screen.h"
+#include "bitmap.h"
+#include "output.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 // global variables for a PPM renderer:
 static int rendererPPM_zoomx;
 static int rendererPPM_zoomy;
+static rendererPPMMode rendererPPM_mode;
+static output rendererPPM_output;
 
 /// @brief RENDERER_PPM_STREAM settings:
 /// By default, the PPM renderer will output to `stdout`, however you
@@ -15,63 +21,77 @@ static int rendererPPM_zoomy;
 #   define RENDERER_PPM_STREAM   stdout
 #endif
 
-/// @brief RENDERER_PPM_UNLOCKED settings:
-/// If this macro constant is defined and Konpu uses the POSIX platform, the PPM
-/// renderer will use the "_unlocked" version of `putc` to output characters.
-/// This may be faster, but is thread-UNSAFE.
-#if defined(RENDERER_PPM_UNLOCKED) && KONPU_PLATFORM_POSIX
-#   define RENDERER_PPM_PUTC(character, stream) \
-           putc_unlocked((character), (stream))
-#else
-#   define RENDERER_PPM_PUTC(character, stream)  \
-           putc((character), (stream))
-#endif
+// lookup table: the RGB pixels (P6) or packed bits (P4), zoomed horizontally,
+// of each byte of a bitmap, ie: of a glyph line. It has 256 runs of
+// `rendererPPM_run` bytes.
+static unsigned char *rendererPPM_runs;
+static size_t         rendererPPM_run;
+
+// output buffer with `zoomy` scanlines (written at once)
+static unsigned char *rendererPPM_lines;
+// (or if the output is vectored: two frames of lines, used alternately)
+static int            rendererPPM_parity;
+
+// bitmap of a row of glyphs
+static unsigned char  rendererPPM_bits[GLYPH_HEIGHT * GRID_WIDTH];
 
 
 static int
-canvas_renderToPPM(const_canvas cvas, FILE* stream, int zoomx, int zoomy)
+canvas_renderToPPM(const_canvas cvas, output *out, int zoomx, int zoomy)
 {  CANVAS_ASSERT(cvas);
-   fprintf(stream, "P6\n%d %d\n255\n", zoomx * GLYPH_WIDTH  * cvas.width,
-                                       zoomy * GLYPH_HEIGHT * cvas.height);
-
-   for (int y = 0; y < GLYPH_HEIGHT * cvas.height; y++) {
-       for (int ny = 0; ny < zoomy; ny++) {
-           for (int x = 0; x < cvas.width; x++) {
-               uint64_t glyph = canvas_glyph(cvas, x, y/GLYPH_HEIGHT);
-               unsigned char line = glyph_line(glyph, y%GLYPH_HEIGHT);
-
-               // TODO: read some color "attributes" for cell(x,y).
-               //       fake it for now.
-               static int FG_R = 0xFF, FG_G = 0xFF, FG_B = 0x00;
-               static int BG_R = 0x00, BG_G = 0x00, BG_B = 0x80;
-
-               for (int i = GLYPH_WIDTH - 1; i >= 0; i--) {
-                   if (line & (1 << i)) {
-                      for (int nx = 0; nx < zoomx; nx++) {
-                        RENDERER_PPM_PUTC(FG_R, stream);
-                        RENDERER_PPM_PUTC(FG_G, stream);
-                        RENDERER_PPM_PUTC(FG_B, stream);
-                      }
-                   } else {
-                      for (int nx = 0; nx < zoomx; nx++) {
-                        RENDERER_PPM_PUTC(BG_R, stream);
-                        RENDERER_PPM_PUTC(BG_G, stream);
-                        RENDERER_PPM_PUTC(BG_B, stream);
-                      }
-                   }
-               }
+   assert(cvas.width <= GRID_WIDTH);
+   char header[32];
+   int  size;
+   if (rendererPPM_mode == RENDERER_PPM_MODE_P4)
+      size = snprintf(header, sizeof(header), "P4\n%d %d\n",
+                      zoomx * GLYPH_WIDTH  * cvas.width,
+                      zoomy * GLYPH_HEIGHT * cvas.height);
+   else
+      size = snprintf(header, sizeof(header), "P6\n%d %d\n255\n",
+                      zoomx * GLYPH_WIDTH  * cvas.width,
+                      zoomy * GLYPH_HEIGHT * cvas.height);
+   output_write(out, header, size);
+
+   size_t width = cvas.width * rendererPPM_run; // bytes in a scanline
+   bool   vectored = output_isVectored(out);
+   unsigned char *frame = rendererPPM_lines;
+   if (vectored) {
+      frame += rendererPPM_parity * GLYPH_HEIGHT * GRID_HEIGHT * width;
+      rendererPPM_parity = !rendererPPM_parity;
+   }
+   for (int y = 0; y < cvas.height; y++) {
+       // bitmap of the row (unless the bitmap of the screen is already made)
+       const unsigned char *row = rendererPPM_bits;
+       if (rendererBitmap && cvas.glyphs == rendererScreen.glyphs)
+          row = rendererBitmap + y * GLYPH_HEIGHT * cvas.width;
+       else
+          bitmap_fromCanvasRow(rendererPPM_bits, cvas.width, cvas, y);
+       for (int line = 0; line < GLYPH_HEIGHT; line++) {
+           // build the scanline from the runs of the bytes of the bitmap
+           const unsigned char *bits = row + line * cvas.width;
+           unsigned char *scanline = (vectored)
+                                   ? frame + (y * GLYPH_HEIGHT + line) * width
+                                   : rendererPPM_lines;
+           unsigned char *line_out = scanline;
+           for (int x = 0; x < cvas.width; x++, line_out += rendererPPM_run)
+               memcpy(line_out, rendererPPM_runs + bits[x] * rendererPPM_run,
+                      rendererPPM_run);
+
+           if (vectored) {
+              // reference it `zoomy` times (vertical zoom)
+              for (int ny = 0; ny < zoomy; ny++)
+                  output_writeRef(out, scanline, width);
+           } else {
+              // replicate it (vertical zoom), and write them all
+              for (int ny = 1; ny < zoomy; ny++)
+                  memcpy(scanline + ny * width, scanline, width);
+              output_write(out, scanline, zoomy * width);
            }
        }
    }
 
-   // flush the stream and check for errors
-   fflush(stream);
-   int err = ferror(stream);
-   if (unlikely(err)) {
-      clearerr(stream);
-      rendererSingleton.error++;
-   }
-   return err;
+   // end the frame (write it, or queue it)
+   return output_submit(out);
 }
 
 
@@ -82,11 +102,29 @@ rendererPPM_render(void)
    // TODO: So, we're just forwarding ...
    //       Maybe a `canvas_renderToPPM` function would make sense it we handle
    //       PPM images somewhere else in the code. But will we?...
-   return canvas_renderToPPM(screen, RENDERER_PPM_STREAM,
-                             rendererPPM_zoomx, rendererPPM_zoomy);
+   TRACE_BEGIN("rendererPPM_render");
+   int err = canvas_renderToPPM(rendererScreen, &rendererPPM_output,
+                                rendererPPM_zoomx, rendererPPM_zoomy);
+   TRACE_END("rendererPPM_render");
+   return err;
+}
+
+// `drop` function for the PPM renderer
+static int
+rendererPPM_drop(void)
+{
+   output_drop(&rendererPPM_output);
+   free(rendererPPM_runs);
+   free(rendererPPM_lines);
+   rendererPPM_runs  = NULL;
+   rendererPPM_lines = NULL;
+   return 0;
 }
 
 int rendererPPM_init(int zoomx, int zoomy)
+{ return rendererPPM_initWithMode(zoomx, zoomy, RENDERER_PPM_MODE_P6); }
+
+int rendererPPM_initWithMode(int zoomx, int zoomy, rendererPPMMode mode)
 {
    // Assuming a dimension with 200 glyphs in one direction, 20*8*200 is max
    // value which wouldn't overflow 15 bits (the max value a int may have if
@@ -94,16 +132,59 @@ int rendererPPM_init(int zoomx, int zoomy)
    // default value (3) if range is incorrect)
    if ((zoomx <= 0) || (zoomx > 20))   zoomx = 3;
    if ((zoomy <= 0) || (zoomy > 20))   zoomy = 3;
-   rendererPPM_zoomx = zoomx;
-   rendererPPM_zoomy = zoomy;
 
    // drop the active renderer (we can't do error checking)
    renderer_drop();
    rendererSingleton.error  = 0;
 
+   // allocate the lookup table and the output buffer
+   if (mode != RENDERER_PPM_MODE_P4)   mode = RENDERER_PPM_MODE_P6;
+   size_t run = (mode == RENDERER_PPM_MODE_P4) ? zoomx  // 8*zoomx bits
+                                               : 3 * GLYPH_WIDTH * zoomx;
+   if (output_init(&rendererPPM_output, RENDERER_PPM_STREAM,
+                   32 + zoomy * GLYPH_HEIGHT * GRID_HEIGHT * GRID_WIDTH * run))
+      return -1;
+   size_t lines = (output_isVectored(&rendererPPM_output))
+                  ? 2 * GLYPH_HEIGHT * GRID_HEIGHT : zoomy;
+   rendererPPM_runs  = malloc(256 * run);
+   rendererPPM_lines = malloc(lines * GRID_WIDTH * run);
+   if (rendererPPM_runs == NULL || rendererPPM_lines == NULL) {
+      rendererPPM_drop();
+      return -1;
+   }
+   rendererPPM_parity = 0;
+   rendererPPM_zoomx = zoomx;
+   rendererPPM_zoomy = zoomy;
+   rendererPPM_run   = run;
+   rendererPPM_mode  = mode;
+
+   // fill the lookup table
+   // TODO: read some color "attributes" for cell(x,y).
+   //       fake it for now.
+   static const unsigned char FG[3] = { 0xFF, 0xFF, 0x00 };
+   static const unsigned char BG[3] = { 0x00, 0x00, 0x80 };
+   for (int byte = 0; byte < 256; byte++) {
+       unsigned char *out = rendererPPM_runs + byte * run;
+       if (mode == RENDERER_PPM_MODE_P4) {
+          // in PBM, a bit set is black, so we invert the bits to show the
+          // set pixels in white, ie: brighter than the unset ones (as in P6)
+          memset(out, 0, run);
+          for (int i = 0; i < GLYPH_WIDTH * zoomx; i++)
+              if (!(byte & (0x80 >> (i / zoomx))))
+                 out[i / 8] |= 0x80 >> (i % 8);
+       } else {
+          for (int i = GLYPH_WIDTH - 1; i >= 0; i--) {
+              const unsigned char *rgb = (byte & (1 << i)) ? FG : BG;
+              for (int nx = 0; nx < zoomx; nx++, out += 3)
+                  memcpy(out, rgb, 3);
+          }
+       }
+   }
+
    // set the active render
    rendererSingleton.id     = RENDERER_PPM;
    rendererSingleton.render = &rendererPPM_render;
+   rendererSingleton.drop   = &rendererPPM_drop;
    render();
    return 0;
 }
@@ -1,7 +1,7 @@
 /*******************************************************************************
  * @file
  * The PPM renderer prints the canvas on C standard output as a "P6" PPM image
- * see: https://en.wikipedia.org/wiki/Netpbm
+ * or as a 1-bit "P4" PBM image, see: https://en.wikipedia.org/wiki/Netpbm
  *
  * This might be used, for example, to create a simple konpu program in pure C,
  * and then from your shell pipe its output into a media player, such as
@@ -21,12 +21,28 @@
 ///         When the given values of zoomx and zoomy are not in [1-20],
 ///         Konpu will choose some default sensible value instead.
 /// @return 0 iff initialization if successful
-///         (always the case if the renderer if available)
+///         (it may only fail if the renderer can't allocate its buffers
+///          or set up its output, see `output_configure`)
 int rendererPPM_init(int zoomx, int zoomy);
 
+/// @brief  format of the images output by the PPM renderer
+typedef enum rendererPPMMode {
+   RENDERER_PPM_MODE_P6, ///< "P6" PPM: 24-bit RGB pixels
+   RENDERER_PPM_MODE_P4, ///< "P4" PBM: 1-bit pixels packed in bytes (24x
+                         ///< smaller). The pixels which are set are white,
+                         ///< and the others are black.
+} rendererPPMMode;
+
+/// @brief  initialize the "PPM" renderer with the given format
+/// @param  zoomx, zoomy: same as for `rendererPPM_init`
+/// @param  mode  format of the images (`rendererPPM_init` uses P6)
+/// @return 0 iff initialization if successful
+int rendererPPM_initWithMode(int zoomx, int zoomy, rendererPPMMode mode);
+
 #else
-#   define RENDERER_PPM                    0
-#   define rendererPPM_init(zoomx, zoomy)  1
+#   define RENDERER_PPM                                    0
+#   define rendererPPM_init(zoomx, zoomy)                  1
+#   define rendererPPM_initWithMode(zoomx, zoomy, mode)    1
 
 #endif //KONPU_PLATFORM_LIBC
 #endif //KONPU_RENDERER_PPM_H
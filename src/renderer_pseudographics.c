@@ -2,7 +2,16 @@
 #if RENDERER_PSEUDOGRAPHICS
 #include "renderer.h"
 #include "screen.h"
+#include "bitmap.h"
+#include "output.h"
+#include "util.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CPU_X86
+#   include <immintrin.h>
+#endif
 
 
 /// @brief RENDERER_PSEUDOGRAPHICS_STREAM settings:
@@ -12,312 +21,823 @@
 #   define RENDERER_PSEUDOGRAPHICS_STREAM   stdout
 #endif
 
-// flush the stream and check/return errors
-// if error are found, clean stream, increment renderer's error count
+// output of the PseudoGraphics renderer
+static output rendererPseudoGraphics_output;
+
+// the options, and whether the stream is treated as a terminal
+static rendererPseudoGraphicsOptions rendererPseudoGraphics_options;
+static bool rendererPseudoGraphics_terminal;
+static int  rendererPseudoGraphics_rows; // number of rows of cells
+static int  rendererPseudoGraphics_cellWidth, rendererPseudoGraphics_cellHeight;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The screen is encoded cell by cell, a cell being a character which shows
+// `width` x `height` pixels (at most 2x4). The pixels of a cell make its "code"
+// with one bit per pixel, in the order of the glyph lines, ie: row by row from
+// the top and from left to right in a row, the top-left pixel being the most
+// significant bit. For example, the code of a quadrant is: TL TR BL BR.
+//
+// Then the encoders work on the bitmap of the screen: for each byte of a line,
+// they spread its bits with a lookup table into a word with a lane (byte) per
+// cell, so a few shifts and ors over the `height` lines of the cells make all
+// their codes at once. But some modes have their own kernels: the quadrants
+// and braille cells, whose height divides the height of a glyph, are gathered
+// straight from the glyphs (with PEXT if the cpu has BMI2), and the sextants
+// work on words of 8 bytes of their three scanlines. Then another lookup table
+// gives the UTF-8 of each code.
+
+// lookup table: the character of each cell code, in UTF-8 (padded to 4 bytes,
+// so that it's always copied as 4 bytes)
+static struct rendererPseudoGraphicsChar {
+   unsigned char utf8[4];
+   unsigned char size;
+} rendererPseudoGraphics_chars[256];
+
+// lookup table: the bits of a byte spread in the lanes of the cells
+// (the leftmost cell being the least significant lane)
+static uint64_t rendererPseudoGraphics_spread[256];
+
+// bitmap of the screen, with a few more lines (when the height of the cells
+// doesn't divide the height of the screen, the last ones overlap the bottom)
+static unsigned char  *rendererPseudoGraphics_bits;
+
+// grids of the codes of the cells: of this frame, and of the last frame
+// which was output (for differential updates)
+static unsigned char  *rendererPseudoGraphics_codes;
+static unsigned char  *rendererPseudoGraphics_lastCodes;
+static bool            rendererPseudoGraphics_repaint; // lastCodes is invalid
+static int             rendererPseudoGraphics_lastColumns; // dimensions of the
+static int             rendererPseudoGraphics_lastRows;    // last frame (or 0)
+
+// colors of the glyphs of the last frame which was output (for differential
+// updates, the cells of the glyphs whose colors changed are drawn again)
+static glyphColors    *rendererPseudoGraphics_lastColors;
+
+// colors of the terminal, ie: the colors set by the last SGR escape sequence
+// (as given by the glyph and after conversion to the colors of the mode)
+static glyphColors     rendererPseudoGraphics_sgrSource;
+static glyphColors     rendererPseudoGraphics_sgr;
+#define RENDERER_PSEUDOGRAPHICS_NOCOLOR  UINT32_MAX // (unknown color)
+
+// frame buffer (written at once)
+// (or if the output is vectored: two frame buffers, used alternately)
+static unsigned char  *rendererPseudoGraphics_frame;
+static size_t          rendererPseudoGraphics_frameCapacity;
+static int             rendererPseudoGraphics_parity;
+
+
+// append a string to the frame
+static inline unsigned char*
+rendererPseudoGraphics_puts(unsigned char *out, const char *str)
+{  size_t size = strlen(str);
+   memcpy(out, str, size);
+   return out + size;
+}
+
+// append a number (>= 0) in decimal to the frame
+static inline unsigned char*
+rendererPseudoGraphics_putNumber(unsigned char *out, int n)
+{  unsigned char digits[12];
+   int i = 0;
+   do { digits[i++] = '0' + n % 10; n /= 10; } while (n);
+   while (i)   *out++ = digits[--i];
+   return out;
+}
+
+// number of bytes of the escape sequence moving the cursor to cell (x,y)
+static inline int
+rendererPseudoGraphics_cupSize(int x, int y)
+{  int size = 4; // ESC [ ; H
+   for (x++; x; x /= 10)  size++;
+   for (y++; y; y /= 10)  size++;
+   return size;
+}
+
+// append the escape sequence moving the cursor to cell (x,y), ie: CUP
+static inline unsigned char*
+rendererPseudoGraphics_cup(unsigned char *out, int x, int y)
+{  *out++ = 0x1b;
+   *out++ = '[';
+   out = rendererPseudoGraphics_putNumber(out, y + 1);
+   *out++ = ';';
+   out = rendererPseudoGraphics_putNumber(out, x + 1);
+   *out++ = 'H';
+   return out;
+}
+
+// index in xterm's palette of the color nearest to an RGB color: either in
+// the 6x6x6 color cube (whose levels are 0, 95, 135, ..., 255) or in the
+// grayscale ramp (whose levels are 8, 18, ..., 238)
+static unsigned
+rendererPseudoGraphics_xterm256(uint32_t rgb)
+{  int c[3] = { rgb >> 16 & 0xff, rgb >> 8 & 0xff, rgb & 0xff };
+   int cube[3], distCube = 0, distGray = 0;
+   for (int i = 0; i < 3; i++) {
+       cube[i] = (c[i] < 48) ? 0 : (c[i] < 115) ? 1 : (c[i] - 35) / 40;
+       int level = (cube[i]) ? 55 + 40 * cube[i] : 0;
+       distCube += (c[i] - level) * (c[i] - level);
+   }
+   int gray = ((c[0] + c[1] + c[2]) / 3 - 3) / 10;
+   UTIL_CLAMP(gray, 23);
+   for (int i = 0; i < 3; i++)
+       distGray += (c[i] - 8 - 10 * gray) * (c[i] - 8 - 10 * gray);
+   return (distGray < distCube) ? 232 + gray
+                                : 16 + 36 * cube[0] + 6 * cube[1] + cube[2];
+}
+
+// append the parameters of SGR setting a color (`base` is 30 for the
+// foreground, 40 for the background)
+static inline unsigned char*
+rendererPseudoGraphics_putColor(unsigned char *out, uint32_t color, int base)
+{  if (color == COLOR_DEFAULT)
+      return rendererPseudoGraphics_putNumber(out, base + 9);
+   out = rendererPseudoGraphics_putNumber(out, base + 8);
+   if (color_isIndex(color)) {
+      out = rendererPseudoGraphics_puts(out, ";5;");
+      return rendererPseudoGraphics_putNumber(out, color_value(color));
+   }
+   out = rendererPseudoGraphics_puts(out, ";2;");
+   out = rendererPseudoGraphics_putNumber(out, color_value(color) >> 16);
+   *out++ = ';';
+   out = rendererPseudoGraphics_putNumber(out, color_value(color) >> 8 & 0xff);
+   *out++ = ';';
+   return rendererPseudoGraphics_putNumber(out, color_value(color) & 0xff);
+}
+
+// append the SGR escape sequence setting the given colors, unless those are
+// already the colors of the terminal
+static inline unsigned char*
+rendererPseudoGraphics_putColors(unsigned char *out, glyphColors colors)
+{  if (likely(colors.fg == rendererPseudoGraphics_sgrSource.fg &&
+              colors.bg == rendererPseudoGraphics_sgrSource.bg))
+      return out;
+   rendererPseudoGraphics_sgrSource = colors;
+
+   if (rendererPseudoGraphics_options.colors == RENDERER_PSEUDOGRAPHICS_COLORS_256) {
+      if (color_isRGB(colors.fg))
+         colors.fg = COLOR_INDEX(rendererPseudoGraphics_xterm256(color_value(colors.fg)));
+      if (color_isRGB(colors.bg))
+         colors.bg = COLOR_INDEX(rendererPseudoGraphics_xterm256(color_value(colors.bg)));
+   }
+   bool fg = (colors.fg != rendererPseudoGraphics_sgr.fg);
+   bool bg = (colors.bg != rendererPseudoGraphics_sgr.bg);
+   if (!fg && !bg)
+      return out;
+   rendererPseudoGraphics_sgr = colors;
+
+   *out++ = 0x1b;
+   *out++ = '[';
+   if (fg)         out = rendererPseudoGraphics_putColor(out, colors.fg, 30);
+   if (fg && bg)   *out++ = ';';
+   if (bg)         out = rendererPseudoGraphics_putColor(out, colors.bg, 40);
+   *out++ = 'm';
+   return out;
+}
+
+// forget the colors of the terminal (the next cell will set them)
+static inline void
+rendererPseudoGraphics_resetColors(void)
+{  rendererPseudoGraphics_sgrSource.fg = rendererPseudoGraphics_sgrSource.bg =
+   rendererPseudoGraphics_sgr.fg       = rendererPseudoGraphics_sgr.bg       =
+      RENDERER_PSEUDOGRAPHICS_NOCOLOR;
+}
+
+// append the characters of `count` cells of row `y` (whose codes are `codes`),
+// starting at column `x`, to the frame
+static inline unsigned char*
+rendererPseudoGraphics_putCells(unsigned char *out, const unsigned char *codes,
+                                int y, int x, int count)
+{  if (rendererPseudoGraphics_options.colors) {
+      // cells with the colors of their glyphs
+      int glyphCells = GLYPH_WIDTH / rendererPseudoGraphics_cellWidth;
+      const glyphColors *colors = rendererColors + rendererScreen.stride *
+         (y * rendererPseudoGraphics_cellHeight / GLYPH_HEIGHT);
+      for (int end = x + count; x < end; x++) {
+          out = rendererPseudoGraphics_putColors(out, colors[x / glyphCells]);
+          const struct rendererPseudoGraphicsChar *c =
+             rendererPseudoGraphics_chars + codes[x];
+          memcpy(out, c->utf8, 4);
+          out += c->size;
+      }
+      return out;
+   }
+
+   for (int end = x + count; x < end; x++) {
+       const struct rendererPseudoGraphicsChar *c =
+          rendererPseudoGraphics_chars + codes[x];
+       memcpy(out, c->utf8, 4);
+       out += c->size;
+   }
+   return out;
+}
+
+// for differential updates: mark the cells of the glyphs whose colors changed
+// since the last frame as changed (so they're drawn again)
+static void
+rendererPseudoGraphics_diffColors(int columns, int rows)
+{  int glyphCells = GLYPH_WIDTH / rendererPseudoGraphics_cellWidth;
+   for (int y = 0; y < rows; y++) {
+       int gy = y * rendererPseudoGraphics_cellHeight / GLYPH_HEIGHT;
+       const glyphColors *now  = rendererColors + gy * rendererScreen.stride;
+       const glyphColors *last = rendererPseudoGraphics_lastColors + gy * rendererScreen.width;
+       const unsigned char *codes = rendererPseudoGraphics_codes + y * columns;
+       unsigned char       *lastCodes = rendererPseudoGraphics_lastCodes + y * columns;
+       for (int gx = 0; gx < rendererScreen.width; gx++)
+           if (now[gx].fg != last[gx].fg || now[gx].bg != last[gx].bg)
+              for (int x = gx * glyphCells; x < (gx + 1) * glyphCells; x++)
+                  lastCodes[x] = ~codes[x];
+   }
+}
+
+// keep the colors of this frame as the colors of the last frame
+static void
+rendererPseudoGraphics_keepColors(void)
+{  for (int gy = 0; gy < rendererScreen.height; gy++)
+       memcpy(rendererPseudoGraphics_lastColors + gy * rendererScreen.width,
+              rendererColors + gy * rendererScreen.stride,
+              rendererScreen.width * sizeof(glyphColors));
+}
+
+// append the cells of a row which differ from the last frame, as runs placed
+// with CUP. Unchanged cells between two changes are rewritten when that's
+// shorter than moving the cursor over them.
+static unsigned char*
+rendererPseudoGraphics_putChanges(unsigned char *out, int y, int columns,
+                                  const unsigned char *now,
+                                  const unsigned char *last)
+{  int x = 0;
+   while (true) {
+      while (x < columns && now[x] == last[x])   x++;
+      if (x == columns)   return out;
+
+      // a run starts at x
+      out = rendererPseudoGraphics_cup(out, x, y);
+      while (true) {
+         int start = x;
+         while (x < columns && now[x] != last[x])   x++;
+         out = rendererPseudoGraphics_putCells(out, now, y, start, x - start);
+
+         // skip the unchanged cells, unless they're cheaper than a CUP
+         int gap = x;
+         while (x < columns && now[x] == last[x])   x++;
+         if (x == columns)   return out;
+         int size = 0;
+         for (int i = gap; i < x; i++)
+             size += rendererPseudoGraphics_chars[now[i]].size;
+         if (size > rendererPseudoGraphics_cupSize(x, y))
+            break;
+         out = rendererPseudoGraphics_putCells(out, now, y, gap, x - gap);
+      }
+   }
+}
+
+// submit the frame, return 0 iff successful
 static int
-rendererPseudoGraphics_fflush()
-{
-   fflush(RENDERER_PSEUDOGRAPHICS_STREAM);
-   int err = ferror(RENDERER_PSEUDOGRAPHICS_STREAM);
-   if (unlikely(err)) {
-      clearerr(RENDERER_PSEUDOGRAPHICS_STREAM);
-      rendererSingleton.error++;
+rendererPseudoGraphics_submit(void)
+{  if (output_submit(&rendererPseudoGraphics_output)) {
+      // a frame may be missing on the terminal, so the next one can't be a
+      // differential update, nor rely on the colors of the terminal
+      rendererPseudoGraphics_repaint = true;
+      rendererPseudoGraphics_resetColors();
+      return -1;
    }
-   return err;
+   return 0;
 }
 
+// output the frame of the grid of codes
+static int
+rendererPseudoGraphics_emit(int columns, int rows)
+{
+   unsigned char *frame = rendererPseudoGraphics_frame;
+   if (output_isVectored(&rendererPseudoGraphics_output)) {
+      frame += rendererPseudoGraphics_parity * rendererPseudoGraphics_frameCapacity;
+      rendererPseudoGraphics_parity = !rendererPseudoGraphics_parity;
+   }
+   unsigned char *out   = frame;
+   unsigned char *codes = rendererPseudoGraphics_codes;
+   unsigned char *last  = rendererPseudoGraphics_lastCodes;
+
+   if (!rendererPseudoGraphics_terminal) {
+      // plain text: the rows, one per line
+      for (int y = 0; y < rows; y++, codes += columns) {
+          out = rendererPseudoGraphics_putCells(out, codes, y, 0, columns);
+          *out++ = 0x0a; // '\n'
+      }
+   } else {
+      // a frame with other dimensions than the last one is a full repaint,
+      // on a cleared terminal
+      bool resized = rendererPseudoGraphics_lastColumns &&
+                     (columns != rendererPseudoGraphics_lastColumns ||
+                      rows    != rendererPseudoGraphics_lastRows);
+      rendererPseudoGraphics_lastColumns = columns;
+      rendererPseudoGraphics_lastRows    = rows;
+
+      // count the changed cells, to choose between a differential update or
+      // a full repaint
+      bool repaint = rendererPseudoGraphics_repaint || resized ||
+                    !rendererPseudoGraphics_options.differential;
+      long changes = 0;
+      if (rendererPseudoGraphics_lastColors) {
+         if (!repaint)
+            rendererPseudoGraphics_diffColors(columns, rows);
+         rendererPseudoGraphics_keepColors();
+      }
+      if (!repaint) {
+         for (int i = 0; i < columns * rows; i++)
+             changes += (codes[i] != last[i]);
+         if (changes == 0) // (an empty frame, which is never dropped)
+            return rendererPseudoGraphics_submit();
+         repaint = (changes * 100 > (long)RENDERER_PSEUDOGRAPHICS_REPAINT * columns * rows);
+      }
+
+      if (rendererPseudoGraphics_options.synchronized)
+         out = rendererPseudoGraphics_puts(out, "\x1b[?2026h");
+      if (repaint) {
+         out = rendererPseudoGraphics_puts(out, (resized) ? "\x1b[H\x1b[2J" : "\x1b[H");
+         for (int y = 0; y < rows; y++, codes += columns) {
+             if (y)   out = rendererPseudoGraphics_puts(out, "\r\n");
+             out = rendererPseudoGraphics_putCells(out, codes, y, 0, columns);
+         }
+      } else {
+         for (int y = 0; y < rows; y++, codes += columns, last += columns)
+             if (memcmp(codes, last, columns))
+                out = rendererPseudoGraphics_putChanges(out, y, columns, codes, last);
+      }
+      if (rendererPseudoGraphics_options.synchronized)
+         out = rendererPseudoGraphics_puts(out, "\x1b[?2026l");
+
+      // this frame is now the last frame
+      unsigned char *swap = rendererPseudoGraphics_lastCodes;
+      rendererPseudoGraphics_lastCodes = rendererPseudoGraphics_codes;
+      rendererPseudoGraphics_codes     = swap;
+      rendererPseudoGraphics_repaint   = false;
+   }
+   assert((size_t)(out - frame) <= rendererPseudoGraphics_frameCapacity);
 
-/// @brief RENDERER_PSEUDOGRAPHICS_UNLOCKED settings:
-/// If this macro constant is defined and Konpu uses the POSIX platform, the
-/// PseudoGraphics renderer will use the "_unlocked" version of `putc` to output
-/// characters. This may be faster, but is thread-UNSAFE.
-#if defined(RENDERER_PSEUDOGRAPHICS_UNLOCKED) && KONPU_PLATFORM_POSIX
-#   define RENDERER_PSEUDOGRAPHICS_PUTCHAR(character) \
-           putc_unlocked((character), RENDERER_PSEUDOGRAPHICS_STREAM)
+   output_writeRef(&rendererPseudoGraphics_output, frame, out - frame);
+   return rendererPseudoGraphics_submit();
+}
+
+// load or store a word of 8 bytes, the first byte being the least significant
+// lane of the word
+static inline uint64_t
+rendererPseudoGraphics_load(const unsigned char *bytes)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+   uint64_t word;
+   memcpy(&word, bytes, 8);
+   return word;
 #else
-#   define RENDERER_PSEUDOGRAPHICS_PUTCHAR(character) \
-           putc((character), RENDERER_PSEUDOGRAPHICS_STREAM)
+   uint64_t word = 0;
+   for (int i = 0; i < 8; i++)
+       word |= (uint64_t)bytes[i] << (8 * i);
+   return word;
 #endif
+}
 
-// print the two first UTF-8 bytes for a U+25xx "block" character
-#define  RENDERER_PSEUDOGRAPHICS_PUTBLOCK_START() do { \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0xe2);      \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x96);      \
-         } while(0)
-
-// print a U+25xx "block" character (all three bytes)
-#define  RENDERER_PSEUDOGRAPHICS_PUTBLOCK(byte) do {   \
-           RENDERER_PSEUDOGRAPHICS_PUTBLOCK_START();   \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR((byte));    \
-         } while(0)
-
-// TODO: user could decide to clean a terminal or not
-//       put this somewhere ...
-// escape sequence for clearing a terminal, ie: "\x1B[H\x1B[J"
-#define  RENDERER_PSEUDOGRAPHICS_TTY_CLEAR() do { \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x1b); \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x5b); \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x48); \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x1b); \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x5b); \
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x4a); \
-         } while(0)
-
+static inline void
+rendererPseudoGraphics_store(unsigned char *bytes, uint64_t word)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+   memcpy(bytes, &word, 8);
+#else
+   for (int i = 0; i < 8; i++)
+       bytes[i] = word >> (8 * i);
+#endif
+}
 
-////////////////////////////////////////////////////////////////////////////////
+// interleave the lanes of the low halves of two words: the lanes (of `size`
+// bytes) of `a` and `b` alternate in the result
+static inline uint64_t
+rendererPseudoGraphics_interleave(uint64_t a, uint64_t b, int size)
+{  a &= UINT64_C(0xFFFFFFFF);
+   b &= UINT64_C(0xFFFFFFFF);
+   a = (a | a << 16) & UINT64_C(0x0000FFFF0000FFFF);
+   b = (b | b << 16) & UINT64_C(0x0000FFFF0000FFFF);
+   if (size == 1) {
+      a = (a | a << 8) & UINT64_C(0x00FF00FF00FF00FF);
+      b = (b | b << 8) & UINT64_C(0x00FF00FF00FF00FF);
+   }
+   return a | b << (8 * size);
+}
 
-// render screen using "1x1" blocks
-static int rendererPseudoGraphics_renderFullBlocks(void)
-{  CANVAS_ASSERT(screen);
-   for (int y = 0; y < GLYPH_WIDTH * screen.height; y++) {
-       for (int x = 0; x < GLYPH_HEIGHT * screen.width; x++) {
-
-           // get a position for pixel (x,y):
-           uint64_t glyph = canvas_glyph(screen, x / GLYPH_WIDTH, y / GLYPH_HEIGHT);
-           int n = glyph_pixelIndex(x % GLYPH_WIDTH, y % GLYPH_HEIGHT);
-
-           // read pixel value and print space or block accordingly:
-           if (uint_bitValue(glyph, n)) {
-              RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x88); //U+2588 (full block)
-           } else {
-              RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x20); // space
-           }
+// codes of the sextants of 8 bytes of three scanlines (32 cells)
+// In each byte, the k-th pair of bits is the k-th cell of a glyph column, thus
+// masking the k-th pairs of the three words and merging them makes the codes
+// of the k-th cells of the 8 columns at once, in the lanes of a word. Then
+// those four words are interleaved to put the codes in the order of the cells.
+static inline void
+rendererPseudoGraphics_sextantWord(const unsigned char *top, ptrdiff_t pitch,
+                                   unsigned char *codes)
+{  const uint64_t PAIRS = UINT64_C(0x0303030303030303);
+   uint64_t l0 = rendererPseudoGraphics_load(top);
+   uint64_t l1 = rendererPseudoGraphics_load(top + pitch);
+   uint64_t l2 = rendererPseudoGraphics_load(top + 2 * pitch);
+   uint64_t k0 = (l0 >> 2 & PAIRS << 4) | (l1 >> 4 & PAIRS << 2) | (l2 >> 6 & PAIRS);
+   uint64_t k1 = (l0      & PAIRS << 4) | (l1 >> 2 & PAIRS << 2) | (l2 >> 4 & PAIRS);
+   uint64_t k2 = (l0 << 2 & PAIRS << 4) | (l1      & PAIRS << 2) | (l2 >> 2 & PAIRS);
+   uint64_t k3 = (l0 << 4 & PAIRS << 4) | (l1 << 2 & PAIRS << 2) | (l2      & PAIRS);
+
+   // (k0,k1) and (k2,k3) as pairs of codes, then both as runs of 4 codes
+   uint64_t k01lo = rendererPseudoGraphics_interleave(k0,       k1,       1);
+   uint64_t k01hi = rendererPseudoGraphics_interleave(k0 >> 32, k1 >> 32, 1);
+   uint64_t k23lo = rendererPseudoGraphics_interleave(k2,       k3,       1);
+   uint64_t k23hi = rendererPseudoGraphics_interleave(k2 >> 32, k3 >> 32, 1);
+   rendererPseudoGraphics_store(codes,      rendererPseudoGraphics_interleave(k01lo,       k23lo,       2));
+   rendererPseudoGraphics_store(codes +  8, rendererPseudoGraphics_interleave(k01lo >> 32, k23lo >> 32, 2));
+   rendererPseudoGraphics_store(codes + 16, rendererPseudoGraphics_interleave(k01hi,       k23hi,       2));
+   rendererPseudoGraphics_store(codes + 24, rendererPseudoGraphics_interleave(k01hi >> 32, k23hi >> 32, 2));
+}
 
+// codes of the sextants (2x3 cells) of the bitmap
+// The three scanlines of a row of sextants (which may come from two rows of
+// glyphs) are processed as words of 8 bytes, ie: 8 glyph columns at once.
+static void
+rendererPseudoGraphics_sextants(const unsigned char *bits, int pitch, int lines,
+                                unsigned char *codes)
+{  for (int line = 0; line < lines; line += 3, bits += 3 * pitch) {
+       int x = 0;
+       for (; x + 8 <= pitch; x += 8, codes += 32)
+           rendererPseudoGraphics_sextantWord(bits + x, pitch, codes);
+
+       if (x < pitch) { // (the last columns, through zero-padded words)
+          int count = pitch - x;
+          unsigned char words[3 * 8] = {0}, last[32];
+          for (int i = 0; i < 3; i++)
+              memcpy(words + 8 * i, bits + i * pitch + x, count);
+          rendererPseudoGraphics_sextantWord(words, 8, last);
+          memcpy(codes, last, 4 * count);
+          codes += 4 * count;
        }
-       RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x0a); // '\n'
    }
-   return rendererPseudoGraphics_fflush();
 }
 
+// quadrants (2x2) and braille (2x4) cells are made straight from the glyphs:
+// the lines of a glyph split into bands of `height` lines, and a band has four
+// cells. So the code of a cell is a gather of the bits of the glyph given by
+// this mask (for the `k`-th cell of the `band`).
+static inline uint64_t
+rendererPseudoGraphics_cellMask(int height, int band, int k)
+{  uint64_t lines = ((UINT64_C(1) << (8 * height)) - 1)     // lines of the band
+                    << (8 * (GLYPH_HEIGHT - height * (band + 1)));
+   return (UINT64_C(0xC0C0C0C0C0C0C0C0) >> (2 * k)) & lines;
+}
 
-// render screen using "1x2" half blocks
-static int rendererPseudoGraphics_renderHorizontalHalfBlocks(void)
-{  CANVAS_ASSERT(screen);
-   for (int y = 0; y < GLYPH_WIDTH * screen.height; y += 2) {
-       for (int x = 0; x < GLYPH_HEIGHT * screen.width; x++) {
-
-           // get a position for pixel (x,y):
-           uint64_t glyph = canvas_glyph(screen, x / GLYPH_WIDTH, y / GLYPH_HEIGHT);
-           int n = glyph_pixelIndex(x % GLYPH_WIDTH, y % GLYPH_HEIGHT);
-
-           // print half block
-           unsigned char c = uint_bitValue(glyph, n)               << 1 |
-                             uint_bitValue(glyph, n - GLYPH_WIDTH)      ;
-           switch(c) {
-              case 0 : RENDERER_PSEUDOGRAPHICS_PUTCHAR( 0x20); break; // space
-              case 1 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x84); break; // U+2584 (lower half)
-              case 2 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x80); break; // U+2580 (upper half)
-              case 3 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x88); break; // U+2588 (full block)
-              default: unreachable();
+// portable kernel: for each cell, mask the pairs of bits of its lines, then a
+// multiplication gathers those pairs. (As the pairs are 8 bits apart and
+// moved by multiples of 6 bits, the partial products never overlap, so there
+// is no carry)
+static inline void
+rendererPseudoGraphics_glyphCells(unsigned char *codes, int height)
+{  int columns = 4 * rendererScreen.width;
+   for (int y = 0; y < rendererScreen.height; y++) {
+       const uint64_t *glyphs = canvas_glyphPointer(rendererScreen, 0, y);
+       for (int band = 0; band < GLYPH_HEIGHT / height; band++, codes += columns) {
+           int shift = 8 * (GLYPH_HEIGHT - height * (band + 1));
+           for (int x = 0; x < rendererScreen.width; x++) {
+               uint64_t lines = glyphs[x] >> shift;
+               for (int k = 0; k < 4; k++) {
+                   uint64_t pairs = lines >> (6 - 2 * k);
+                   codes[4 * x + k] = (height == 4)
+                      ? ((pairs & 0x03030303) * 0x41041) >> 18  // 4 pairs
+                      : ((pairs & 0x0303)     * 0x41)    >>  6; // 2 pairs
+               }
            }
-
        }
-       RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x0a); // '\n'
    }
-   return rendererPseudoGraphics_fflush();
 }
 
+static void
+rendererPseudoGraphics_glyphCells_scalar(unsigned char *codes, int height)
+{
+   if (height == 4)   rendererPseudoGraphics_glyphCells(codes, 4);
+   else               rendererPseudoGraphics_glyphCells(codes, 2);
+}
 
-// render screen using "2x1" half blocks
-static int rendererPseudoGraphics_renderVerticalHalfBlocks(void)
-{  CANVAS_ASSERT(screen);
-   for (int y = 0; y < GLYPH_WIDTH * screen.height; y++) {
-       for (int x = 0; x < GLYPH_HEIGHT * screen.width; x += 2) {
-
-           // get a position for pixel (x,y):
-           uint64_t glyph = canvas_glyph(screen, x / GLYPH_WIDTH, y / GLYPH_HEIGHT);
-           int n = glyph_pixelIndex(x % GLYPH_WIDTH, y % GLYPH_HEIGHT);
-
-           // print vertical half block
-           unsigned char c = uint_bitValue(glyph, n)     << 1 |
-                             uint_bitValue(glyph, n - 1)      ;
-           switch(c) {
-              case 0 : RENDERER_PSEUDOGRAPHICS_PUTCHAR( 0x20); break; // space
-              case 1 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x90); break; // U+2590 (right half)
-              case 2 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x8c); break; // U+258C (left half)
-              case 3 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x88); break; // U+2588 (full block)
-              default: unreachable();
+#if CPU_X86
+// BMI2 kernel: the code of a cell is one PEXT of the glyph with its mask
+__attribute__((target("bmi2"))) static void
+rendererPseudoGraphics_glyphCells_bmi2(unsigned char *codes, int height)
+{  int columns = 4 * rendererScreen.width;
+   for (int y = 0; y < rendererScreen.height; y++) {
+       const uint64_t *glyphs = canvas_glyphPointer(rendererScreen, 0, y);
+       for (int band = 0; band < GLYPH_HEIGHT / height; band++, codes += columns) {
+           uint64_t masks[4];
+           for (int k = 0; k < 4; k++)
+               masks[k] = rendererPseudoGraphics_cellMask(height, band, k);
+           for (int x = 0; x < rendererScreen.width; x++) {
+               uint64_t glyph = glyphs[x];
+               for (int k = 0; k < 4; k++)
+                   codes[4 * x + k] = _pext_u64(glyph, masks[k]);
            }
-
        }
-       RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x0a); // '\n'
    }
-   return rendererPseudoGraphics_fflush();
 }
+#endif
 
-
-// render screen using "2x2" quadrant blocks
-static int rendererPseudoGraphics_renderQuadBlocks(void)
-{  CANVAS_ASSERT(screen);
-   for (int y = 0; y < GLYPH_WIDTH * screen.height; y += 2) {
-       for (int x = 0; x < GLYPH_HEIGHT * screen.width; x += 2) {
-
-           // get a position for pixel (x,y):
-           uint64_t glyph = canvas_glyph(screen, x / GLYPH_WIDTH, y / GLYPH_HEIGHT);
-           int n = glyph_pixelIndex(x % GLYPH_WIDTH, y % GLYPH_HEIGHT);
-
-           // read a half block character and print it out:
-           unsigned char c = uint_bitValue(glyph, n)                   << 3 |
-                             uint_bitValue(glyph, n - 1)               << 2 |
-                             uint_bitValue(glyph, n - GLYPH_WIDTH)     << 1 |
-                             uint_bitValue(glyph, n - GLYPH_WIDTH - 1)      ;
-
-           // print it out as UTF-8
-           static unsigned char quad_lastbyte[] = {
-              0x20, 0x97, 0x96, 0x84, 0x9d, 0x90, 0x9e, 0x9f,
-              0x98, 0x9a, 0x8c, 0x99, 0x80, 0x9c, 0x9b, 0x88  };
-           if (c)  RENDERER_PSEUDOGRAPHICS_PUTBLOCK_START();
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(quad_lastbyte[c]);
-
-       }
-       RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x0a); // '\n'
+// kernel selected by `rendererPseudoGraphics_init`
+static void (*rendererPseudoGraphics_glyphKernel)(unsigned char*, int) =
+   &rendererPseudoGraphics_glyphCells_scalar;
+
+
+// encode the screen into the grid of codes, and output the frame
+// (it's inlined in the `render` function of each mode, so that the compiler
+//  can unroll the loops for the given dimensions of the cells)
+static inline int
+rendererPseudoGraphics_encode(int width, int height)
+{  CANVAS_ASSERT(rendererScreen);
+   assert(rendererScreen.width <= GRID_WIDTH && rendererScreen.height <= GRID_HEIGHT);
+   int pitch = rendererScreen.width; // bytes in a line of the bitmap
+   int lines = GLYPH_HEIGHT * rendererScreen.height;
+   int rows  = (lines + height - 1) / height;
+   TRACE_BEGIN("rendererPseudoGraphics_render");
+
+   unsigned char *codes = rendererPseudoGraphics_codes;
+   if (width == 2 && (height == 2 || height == 4)) {
+      (*rendererPseudoGraphics_glyphKernel)(codes, height);
+   } else {
+      // get the bitmap of the screen (unless it's already made)
+      const unsigned char *bits = rendererBitmap;
+      if (bits == NULL) {
+         unsigned char *own = rendererPseudoGraphics_bits;
+         for (int y = 0; y < rendererScreen.height; y++)
+             bitmap_fromCanvasRow(own + y * GLYPH_HEIGHT * pitch, pitch, rendererScreen, y);
+         memset(own + lines * pitch, 0, (height - 1) * pitch);
+         bits = own;
+      }
+
+      if (width == 2 && height == 3) {
+         rendererPseudoGraphics_sextants(bits, pitch, lines, codes);
+      } else {
+         for (int line = 0; line < lines; line += height, bits += height * pitch) {
+             for (int x = 0; x < pitch; x++) {
+                 // codes of the cells of this byte
+                 uint64_t lanes = 0;
+                 for (int i = 0; i < height; i++)
+                     lanes = (lanes << width) | rendererPseudoGraphics_spread[bits[i * pitch + x]];
+                 for (int i = 0; i < GLYPH_WIDTH; i += width, lanes >>= 8)
+                     *codes++ = lanes & 0xff;
+             }
+         }
+      }
    }
-   return rendererPseudoGraphics_fflush();
+
+   int err = rendererPseudoGraphics_emit(GLYPH_WIDTH * pitch / width, rows);
+   TRACE_END("rendererPseudoGraphics_render");
+   return err;
 }
 
+// render screen using "1x1" blocks
+static int rendererPseudoGraphics_renderFullBlocks(void)
+{ return rendererPseudoGraphics_encode(1, 1); }
 
-// render screen using "2x4" braille dots
-static int rendererPseudoGraphics_renderBrailleDots(void)
-{  CANVAS_ASSERT(screen);
-   for (int y = 0; y < GLYPH_WIDTH * screen.height; y += 4) {
-       for (int x = 0; x < GLYPH_HEIGHT * screen.width; x += 2) {
-
-           // get a position for pixel (x,y):
-           uint64_t glyph = canvas_glyph(screen, x / GLYPH_WIDTH, y / GLYPH_HEIGHT);
-           int n = glyph_pixelIndex(x % GLYPH_WIDTH, y % GLYPH_HEIGHT);
-
-           // Read the 2x4 bit pixels of the braille cell.        0x01 0x08
-           // The 'Braille Patterns' Unicode block assigns  ___\  0x02 0x10
-           // the codepoint 0x28XX, with XX being computed     /  0x04 0x20
-           // with those weights for the raised bits,             0x40 0x80
-           unsigned char braille =
-              uint_bitValue(glyph, n                      ) * 0x01 |
-              uint_bitValue(glyph, n -                   1) * 0x08 |
-              uint_bitValue(glyph, n -     GLYPH_WIDTH    ) * 0x02 |
-              uint_bitValue(glyph, n -     GLYPH_WIDTH - 1) * 0x10 |
-              uint_bitValue(glyph, n - 2 * GLYPH_WIDTH    ) * 0x04 |
-              uint_bitValue(glyph, n - 2 * GLYPH_WIDTH - 1) * 0x20 |
-              uint_bitValue(glyph, n - 3 * GLYPH_WIDTH    ) * 0x40 |
-              uint_bitValue(glyph, n - 3 * GLYPH_WIDTH - 1) * 0x80 ;
-
-           // conversion to UTF-8 representation (3 bytes) reduces to:
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0xe2);
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR(0xa0 | (braille >> 6));
-           RENDERER_PSEUDOGRAPHICS_PUTCHAR( 128 | (braille & 63));
+// render screen using "1x2" half blocks
+static int rendererPseudoGraphics_renderHorizontalHalfBlocks(void)
+{ return rendererPseudoGraphics_encode(1, 2); }
 
-       }
-       RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x0a); // '\n'
-   }
-   return rendererPseudoGraphics_fflush();
-}
+// render screen using "2x1" half blocks
+static int rendererPseudoGraphics_renderVerticalHalfBlocks(void)
+{ return rendererPseudoGraphics_encode(2, 1); }
 
+// render screen using "2x2" quadrant blocks
+static int rendererPseudoGraphics_renderQuadBlocks(void)
+{ return rendererPseudoGraphics_encode(2, 2); }
 
 // render screen using "2x3" sextants blocks
-// TODO/FIXME: this rendered is broken!
-//             especially, when the sextant must read "pixel" from two glyphs,
-//             this is not working properly.
 static int rendererPseudoGraphics_renderSextantBlocks(void)
-{  CANVAS_ASSERT(screen);
-   // The main issue with sextants is their height (3) isn't a divisor of the
-   // glyph's height. The info to put in a sextant might come from TWO glyphs.
-
-   for (int y = 0; y < GLYPH_WIDTH * screen.height; y += 3) {
-       for (int x = 0; x < GLYPH_HEIGHT * screen.width; x += 2) {
-
-           // glyph from which the sextant info comes from ...
-           uint64_t glyph = canvas_glyph(screen, x / GLYPH_WIDTH, y / GLYPH_HEIGHT);
-           int ypos = y % (GLYPH_WIDTH);
-           int n = glyph_pixelIndex(x % GLYPH_WIDTH, ypos);
-
-           // read the sextant pixels
-           unsigned sext = uint_bitValue(glyph, n                      ) << 5 |
-                           uint_bitValue(glyph, n -                   1) << 4 ;
-                           // we started by reading the first line
-           switch (ypos) {
-              default:     // we can read the two following line from same glyph
-                  sext |=  uint_bitValue(glyph, n -     GLYPH_WIDTH    ) << 3 |
-                           uint_bitValue(glyph, n -     GLYPH_WIDTH - 1) << 2 |
-                           uint_bitValue(glyph, n - 2 * GLYPH_WIDTH    ) << 1 |
-                           uint_bitValue(glyph, n - 2 * GLYPH_WIDTH - 1)      ;
-                  break;
-
-              case  6:     // we can read one more line from same glyph
-                  sext |=  uint_bitValue(glyph, n -     GLYPH_WIDTH    ) << 3 |
-                           uint_bitValue(glyph, n -     GLYPH_WIDTH - 1) << 2 ;
-                  if (y > GLYPH_WIDTH * screen.height)
-                     break;
-                  glyph = *(&glyph + screen.stride); // then we go to the glyph
-                  n = glyph_pixelIndex(x % GLYPH_WIDTH, 0);  //    underneath
-                  sext |=  uint_bitValue(glyph, n                      ) << 2 |
-                           uint_bitValue(glyph, n                   - 1) << 1 ;
-                  break;
-
-              case  7:     // we need to read all the rest from underneath glyph
-                  if (y > GLYPH_WIDTH * screen.height)
-                     break;
-                  glyph = *(&glyph + screen.stride);
-                  n = glyph_pixelIndex(x % GLYPH_WIDTH, 0);
-                  sext |=  uint_bitValue(glyph, n                      ) << 3 |
-                           uint_bitValue(glyph, n                   - 1) << 2 |
-                           uint_bitValue(glyph, n -     GLYPH_WIDTH    ) << 2 |
-                           uint_bitValue(glyph, n -     GLYPH_WIDTH - 1) << 1 ;
-                  break;
-           }
+{ return rendererPseudoGraphics_encode(2, 3); }
 
+// render screen using "2x4" braille dots
+static int rendererPseudoGraphics_renderBrailleDots(void)
+{ return rendererPseudoGraphics_encode(2, 4); }
 
-//TODO/FIXME ASAP NOW: quick ugly temporary hack 'cause we       ^
-//                     built the sextant wrongly!!! FIX ABOVE ---' and remove:
-sext = byte_reverse(sext) >> 2;
-
-
-           // print out the sextant characters in UTF-8
-
-           // codepoints for sextants in the 'Symbols for Legacy Computing'
-           // Unicode blocks are logically arranged as per the bit pixels, but
-           // as sextant can be vertical half blocks, they sometimes have other
-           // codepoints. I first thought to just have a "switch" or lookup for
-           // all 64 cases, but I figured out this logic which isn't so
-           // expensive to compute... do an integer division by 21:
-           // sext = 21 * q + r,
-           //  if r != 0  => codepoint is: (0x1FB00 - 1) + 20*q + r
-           //             => else sextant is a half block.
-           // in terms of UTF-8, codepoint 0x1FBxx is easy to compute.
-
-           unsigned q = sext / 21;
-           if (sext % 21) {
-              // the UTF-8 conversion of codepoint 0x1FB00 - 1 + sext - q
-              // is four bytes and reduces to this:
-              RENDERER_PSEUDOGRAPHICS_PUTCHAR(0xf0);
-              RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x9f);
-              RENDERER_PSEUDOGRAPHICS_PUTCHAR(0xac);
-              RENDERER_PSEUDOGRAPHICS_PUTCHAR(128 | (sext - q - 1));
-           } else {
-              switch(q) { // sext is vertical halves/empty/full
-                 case 0 : RENDERER_PSEUDOGRAPHICS_PUTCHAR( 0x20); break; // space
-                 case 1 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x8c); break; // U+258C (left half)
-                 case 2 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x90); break; // U+2590 (right half)
-                 case 3 : RENDERER_PSEUDOGRAPHICS_PUTBLOCK(0x88); break; // U+2588 (full block)
-                 default: unreachable();
-              }
-           }
 
-       }
-       RENDERER_PSEUDOGRAPHICS_PUTCHAR(0x0a); // '\n'
+////////////////////////////////////////////////////////////////////////////////
+
+// dimensions of the cells of each mode
+static const struct { int width, height; }
+rendererPseudoGraphics_cells[RENDERER_PSEUDOGRAPHICS_MODE_ENUMCOUNT] = {
+   [RENDERER_PSEUDOGRAPHICS_MODE_1x1] = { 1, 1 },
+   [RENDERER_PSEUDOGRAPHICS_MODE_1x2] = { 1, 2 },
+   [RENDERER_PSEUDOGRAPHICS_MODE_2x1] = { 2, 1 },
+   [RENDERER_PSEUDOGRAPHICS_MODE_2x2] = { 2, 2 },
+   [RENDERER_PSEUDOGRAPHICS_MODE_2x3] = { 2, 3 },
+   [RENDERER_PSEUDOGRAPHICS_MODE_2x4] = { 2, 4 },
+};
+
+// return the Unicode codepoint showing the cell of the given code
+static uint32_t
+rendererPseudoGraphics_codepoint(rendererPseudoGraphicsMode mode, unsigned code)
+{
+   switch (mode) {
+      case RENDERER_PSEUDOGRAPHICS_MODE_1x1:
+         return (code) ? 0x2588 : 0x20; // full block or space
+
+      case RENDERER_PSEUDOGRAPHICS_MODE_1x2: {
+         static const uint16_t halves[4] = {
+            0x20, 0x2584, 0x2580, 0x2588 }; // space, lower, upper, full
+         return halves[code];
+      }
+
+      case RENDERER_PSEUDOGRAPHICS_MODE_2x1: {
+         static const uint16_t halves[4] = {
+            0x20, 0x2590, 0x258C, 0x2588 }; // space, right, left, full
+         return halves[code];
+      }
+
+      case RENDERER_PSEUDOGRAPHICS_MODE_2x2: {
+         static const uint16_t quadrants[16] = {
+            0x0020, 0x2597, 0x2596, 0x2584, 0x259D, 0x2590, 0x259E, 0x259F,
+            0x2598, 0x259A, 0x258C, 0x2599, 0x2580, 0x259C, 0x259B, 0x2588 };
+         return quadrants[code];
+      }
+
+      case RENDERER_PSEUDOGRAPHICS_MODE_2x3: {
+         // codepoints for sextants in the 'Symbols for Legacy Computing'
+         // Unicode block are logically arranged as per their pixels, with
+         // weights 1,2 (top), 4,8 (middle) and 16,32 (bottom), but the
+         // vertical halves are skipped as they are in "Block Elements".
+         // So, with `s` the sum of the weights: s = 21 * q + r,
+         //  if r != 0  => codepoint is: (0x1FB00 - 1) + 20*q + r
+         //             => else sextant is a space, half block or full block.
+         unsigned s = 0;
+         for (int i = 0; i < 6; i++)
+             s |= ((code >> (5 - i)) & 1) << i;
+         static const uint16_t halves[4] = {
+            0x20, 0x258C, 0x2590, 0x2588 }; // space, left, right, full
+         return (s % 21) ? 0x1FB00 - 1 + s - s / 21 : halves[s / 21];
+      }
+
+      case RENDERER_PSEUDOGRAPHICS_MODE_2x4: {
+         // The 'Braille Patterns' Unicode block assigns        0x01 0x08
+         // the codepoint 0x28XX, with XX being computed  ___\  0x02 0x10
+         // with those weights for the raised dots:          /  0x04 0x20
+         //                                                     0x40 0x80
+         static const unsigned char dots[8] = {
+            0x01, 0x08, 0x02, 0x10, 0x04, 0x20, 0x40, 0x80 };
+         unsigned braille = 0;
+         for (int i = 0; i < 8; i++)
+             if (code & (0x80 >> i))   braille |= dots[i];
+         return 0x2800 | braille;
+      }
+
+      default: unreachable();
    }
-   return rendererPseudoGraphics_fflush();
 }
 
+// fill the lookup tables for the given mode
+static void
+rendererPseudoGraphics_initTables(rendererPseudoGraphicsMode mode)
+{
+   int width  = rendererPseudoGraphics_cells[mode].width;
+   int height = rendererPseudoGraphics_cells[mode].height;
+
+   // characters in UTF-8
+   for (unsigned code = 0; code < (1u << (width * height)); code++) {
+       struct rendererPseudoGraphicsChar *c = rendererPseudoGraphics_chars + code;
+       uint32_t codepoint = rendererPseudoGraphics_codepoint(mode, code);
+       memset(c->utf8, 0, 4);
+       if (codepoint < 0x80) {
+          c->utf8[0] = codepoint;
+          c->size    = 1;
+       } else if (codepoint < 0x10000) {
+          c->utf8[0] = 0xe0 |  (codepoint >> 12);
+          c->utf8[1] = 0x80 | ((codepoint >>  6) & 0x3f);
+          c->utf8[2] = 0x80 |  (codepoint        & 0x3f);
+          c->size    = 3;
+       } else {
+          c->utf8[0] = 0xf0 |  (codepoint >> 18);
+          c->utf8[1] = 0x80 | ((codepoint >> 12) & 0x3f);
+          c->utf8[2] = 0x80 | ((codepoint >>  6) & 0x3f);
+          c->utf8[3] = 0x80 |  (codepoint        & 0x3f);
+          c->size    = 4;
+       }
+   }
 
-////////////////////////////////////////////////////////////////////////////////
+   // bits of a byte (the `width` bits of a cell) to the lanes of the cells
+   unsigned mask = (1u << width) - 1;
+   for (int byte = 0; byte < 256; byte++) {
+       uint64_t spread = 0;
+       for (int i = 0; i < GLYPH_WIDTH / width; i++)
+           spread |= (uint64_t)((byte >> (GLYPH_WIDTH - width * (i + 1))) & mask) << (8 * i);
+       rendererPseudoGraphics_spread[byte] = spread;
+   }
+}
+
+static int rendererPseudoGraphics_drop(void)
+{
+   output_drop(&rendererPseudoGraphics_output);
+
+   // restore the colors and the terminal
+   FILE *stream = RENDERER_PSEUDOGRAPHICS_STREAM;
+   if (rendererPseudoGraphics_options.colors && rendererPseudoGraphics_frame)
+      fputs("\x1b[0m", stream);
+   if (rendererPseudoGraphics_terminal) {
+      if (rendererPseudoGraphics_options.altScreen)
+         fputs("\x1b[?1049l", stream);
+      else // (put the cursor under the screen)
+         fprintf(stream, "\x1b[%d;1H\n", rendererPseudoGraphics_rows);
+      fputs("\x1b[?25h", stream);
+      rendererPseudoGraphics_terminal = false;
+   }
+   fflush(stream);
+
+   free(rendererPseudoGraphics_bits);
+   free(rendererPseudoGraphics_codes);
+   free(rendererPseudoGraphics_lastCodes);
+   free(rendererPseudoGraphics_lastColors);
+   free(rendererPseudoGraphics_frame);
+   rendererPseudoGraphics_bits       = NULL;
+   rendererPseudoGraphics_codes      = NULL;
+   rendererPseudoGraphics_lastCodes  = NULL;
+   rendererPseudoGraphics_lastColors = NULL;
+   rendererPseudoGraphics_frame      = NULL;
+   return 0;
+}
 
 int rendererPseudoGraphics_init(enum rendererPseudoGraphicsMode mode)
+{ return rendererPseudoGraphics_initWithOptions(mode, NULL); }
+
+int rendererPseudoGraphics_initWithOptions(enum rendererPseudoGraphicsMode mode,
+                                           const rendererPseudoGraphicsOptions *options)
 {
    // drop the active renderer
    renderer_drop();
    rendererSingleton.error = 0;
 
-   // set the active render and render() once
-   rendererSingleton.id = RENDERER_PSEUDOGRAPHICS;
+   if ((unsigned)mode >= RENDERER_PSEUDOGRAPHICS_MODE_ENUMCOUNT)
+      mode = RENDERER_PSEUDOGRAPHICS_MODE_2x3; // default mode
+   int width  = rendererPseudoGraphics_cells[mode].width;
+   int height = rendererPseudoGraphics_cells[mode].height;
+   int columns = GLYPH_WIDTH * GRID_WIDTH / width;
+   int rows    = (GLYPH_HEIGHT * GRID_HEIGHT + height - 1) / height;
+
+   rendererPseudoGraphics_options = (options) ? *options
+                                  : (rendererPseudoGraphicsOptions){0};
+   bool terminal = rendererPseudoGraphics_options.differential ||
+                   rendererPseudoGraphics_options.altScreen    ||
+                   rendererPseudoGraphics_options.synchronized;
+
+   // a frame has at most 4 bytes per cell, plus the newlines. On a terminal,
+   // there may also be a CUP (and bridged unchanged cells, no bigger than a
+   // CUP) for every two cells, a clear, and the synchronized update bracket.
+   // (and we may copy up to 3 bytes more than a frame, as characters are
+   // copied as 4 bytes). With colors, any cell may also have an SGR.
+   size_t capacity = (size_t)(4 * columns + 1) * rows;
+   if (terminal)
+      capacity += (size_t)columns * rows * 2 * rendererPseudoGraphics_cupSize(columns, rows) + 20;
+   if (rendererPseudoGraphics_options.colors)
+      capacity += (size_t)columns * rows * CSTR_LENGTH("\x1b[38;2;255;255;255;48;2;255;255;255m");
+   if (output_init(&rendererPseudoGraphics_output,
+                   RENDERER_PSEUDOGRAPHICS_STREAM, capacity))
+      return -1;
+   int frames = (output_isVectored(&rendererPseudoGraphics_output)) ? 2 : 1;
+   rendererPseudoGraphics_bits      = malloc((GLYPH_HEIGHT * GRID_HEIGHT + height - 1) * GRID_WIDTH);
+   rendererPseudoGraphics_codes     = malloc(columns * rows);
+   rendererPseudoGraphics_lastCodes = malloc(columns * rows);
+   rendererPseudoGraphics_frame     = malloc(frames * (capacity + 3));
+   bool lastColors = rendererPseudoGraphics_options.colors &&
+                     rendererPseudoGraphics_options.differential;
+   if (lastColors)
+      rendererPseudoGraphics_lastColors = malloc(sizeof(glyphColors) * GRID_WIDTH * GRID_HEIGHT);
+   if (rendererPseudoGraphics_bits      == NULL ||
+       rendererPseudoGraphics_codes     == NULL ||
+       rendererPseudoGraphics_lastCodes == NULL ||
+       rendererPseudoGraphics_frame     == NULL ||
+      (rendererPseudoGraphics_lastColors == NULL && lastColors)) {
+      rendererPseudoGraphics_drop();
+      return -1;
+   }
+   rendererPseudoGraphics_frameCapacity = capacity + 3;
+   rendererPseudoGraphics_parity  = 0;
+   rendererPseudoGraphics_repaint = true;
+   rendererPseudoGraphics_lastColumns = 0; // (the terminal is cleared below)
+   rendererPseudoGraphics_lastRows    = 0;
+   rendererPseudoGraphics_cellWidth  = width;
+   rendererPseudoGraphics_cellHeight = height;
+   rendererPseudoGraphics_resetColors();
+   rendererPseudoGraphics_initTables(mode);
+#if CPU_X86
+   if (cpu_hasBMI2())   rendererPseudoGraphics_glyphKernel = &rendererPseudoGraphics_glyphCells_bmi2;
+   else
+#endif
+                        rendererPseudoGraphics_glyphKernel = &rendererPseudoGraphics_glyphCells_scalar;
+
+   // set up the terminal
+   // (written before the first frame, which is submitted later)
+   rendererPseudoGraphics_terminal = terminal;
+   rendererPseudoGraphics_rows     = rows;
+   if (terminal) {
+      FILE *stream = RENDERER_PSEUDOGRAPHICS_STREAM;
+      if (rendererPseudoGraphics_options.altScreen)
+         fputs("\x1b[?1049h", stream);
+      fputs("\x1b[?25l\x1b[H\x1b[2J", stream); // hide the cursor and clear
+   }
+
+   // set the active render
+   rendererSingleton.id   = RENDERER_PSEUDOGRAPHICS;
+   rendererSingleton.drop = &rendererPseudoGraphics_drop;
    switch(mode) {
       case RENDERER_PSEUDOGRAPHICS_MODE_1x1:
          rendererSingleton.render = &rendererPseudoGraphics_renderFullBlocks;
@@ -339,12 +859,6 @@ int rendererPseudoGraphics_init(enum rendererPseudoGraphicsMode mode)
          rendererSingleton.render = &rendererPseudoGraphics_renderSextantBlocks;
          break;
    }
-
-   // TODO: to complete the initialization, we may wish to do something
-   //       if we are writing to a terminal,
-   //       either clear it (RENDERER_PSEUDOGRAPHICS_TTY_CLEAR)
-   //       or move to the alternate screen (if the tty is capable)
-
    return 0;
 }
 
@@ -32,12 +32,62 @@ typedef enum rendererPseudoGraphicsMode {
 /// @param  mode determines the set of pseudo graphics characters to be used.
 ///         (if not in range of the enum, a default choice is chosen by Konpu)
 /// @return 0 iff initialization if successful
-///         (always the case if the renderer if available)
+///         (it may only fail if the renderer can't set up its output, see
+///          `output_configure`)
 int rendererPseudoGraphics_init(enum rendererPseudoGraphicsMode mode);
 
+/// @brief colors of the PseudoGraphics renderer
+typedef enum rendererPseudoGraphicsColors {
+   RENDERER_PSEUDOGRAPHICS_COLORS_NONE,      ///< monochrome (the colors of the terminal)
+   RENDERER_PSEUDOGRAPHICS_COLORS_256,       ///< the 256 colors of xterm (RGB colors
+                                             ///< are mapped to the nearest ones)
+   RENDERER_PSEUDOGRAPHICS_COLORS_TRUECOLOR, ///< 24-bit RGB colors
+} rendererPseudoGraphicsColors;
+
+/// @brief options of the PseudoGraphics renderer
+/// (a zero-initialized struct gives the default options, ie: the frames are
+///  printed one after the other as plain text, which suits a file or a pipe)
+///
+/// The `differential`, `altScreen` and `synchronized` options mean that the
+/// stream is a terminal understanding ANSI escape sequences: the renderer
+/// clears it and hides the cursor, and then draws every frame from its top-left
+/// corner.
+typedef struct rendererPseudoGraphicsOptions {
+   rendererPseudoGraphicsColors colors;
+                      ///< paint the cells with the colors of their glyphs
+                      ///< (see `screenColors`). SGR escape sequences are only
+                      ///< output when the colors change from a cell to the
+                      ///< next one (even across lines or frames).
+   bool differential; ///< only draw the cells which changed since the last
+                      ///< frame, as runs placed with cursor positioning
+                      ///< escapes (or the whole screen when most of it
+                      ///< changed, see RENDERER_PSEUDOGRAPHICS_REPAINT)
+   bool altScreen;    ///< use the alternate screen of the terminal while the
+                      ///< renderer is active (thus, the content of the
+                      ///< terminal is restored when it's dropped)
+   bool synchronized; ///< bracket each frame in a synchronized update (DEC
+                      ///< private mode 2026), so the terminal shows it at
+                      ///< once (terminals not supporting it ignore this)
+} rendererPseudoGraphicsOptions;
+
+/// @brief RENDERER_PSEUDOGRAPHICS_REPAINT settings:
+/// with differential updates, the whole screen is drawn (rather than the
+/// cells which changed) when more than this percentage of cells changed.
+#ifndef    RENDERER_PSEUDOGRAPHICS_REPAINT
+#   define RENDERER_PSEUDOGRAPHICS_REPAINT  50
+#endif
+
+/// @brief  initialize a PseudoGraphics renderer with the given options
+/// @param  options the options (or NULL for the default options)
+/// @details see `rendererPseudoGraphics_init` for the other parameter and the
+///          return value.
+int rendererPseudoGraphics_initWithOptions(enum rendererPseudoGraphicsMode mode,
+                                           const rendererPseudoGraphicsOptions *options);
+
 #else
 #   define RENDERER_PSEUDOGRAPHICS            0
 #   define rendererPseudoGraphics_init(mode)  1
+#   define rendererPseudoGraphics_initWithOptions(mode, options)  1
 
 #endif //KONPU_PLATFORM_LIBC
 #endif //KONPU_RENDERER_PSEUDOGRAPHICS_H
@@ -0,0 +1,185 @@
+#include "renderer_y4m.h"
+#if RENDERER_Y4M
+#include "renderer.h"
+#include "screen.h"
+#include "bitmap.h"
+#include "output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// global variables for a Y4M renderer:
+static int rendererY4M_zoomx;
+static int rendererY4M_zoomy;
+static int rendererY4M_width;  // dimensions of the canvas (in glyphs) given
+static int rendererY4M_height; // in the stream header, which all frames keep
+static output rendererY4M_output;
+
+/// @brief RENDERER_Y4M_STREAM settings:
+/// By default, the Y4M renderer will output to `stdout`, however you
+/// may define another stream by defining this macro constant.
+#ifndef    RENDERER_Y4M_STREAM
+#   define RENDERER_Y4M_STREAM   stdout
+#endif
+
+/// @brief RENDERER_Y4M_FG / RENDERER_Y4M_BG settings:
+/// luma of the pixels which are set / unset (in "video" range: 16-235)
+#ifndef    RENDERER_Y4M_FG
+#   define RENDERER_Y4M_FG       235
+#endif
+#ifndef    RENDERER_Y4M_BG
+#   define RENDERER_Y4M_BG       16
+#endif
+
+// lookup table: the luma (zoomed horizontally) of each byte of a bitmap, ie: of
+// a glyph line. It has 256 runs of `rendererY4M_run` bytes.
+static unsigned char *rendererY4M_runs;
+static size_t         rendererY4M_run;
+
+// output buffer with `zoomy` lines of the luma plane (written at once)
+static unsigned char *rendererY4M_lines;
+// (or if the output is vectored: two frames of lines, used alternately)
+static int            rendererY4M_parity;
+
+// chroma plane (constant, there's no color)
+static unsigned char *rendererY4M_chroma;
+static size_t         rendererY4M_chromaSize;
+
+// bitmap of a row of glyphs
+static unsigned char  rendererY4M_bits[GLYPH_HEIGHT * GRID_WIDTH];
+
+
+// `render` function for the Y4M renderer
+static int
+rendererY4M_render(void)
+{  const_canvas cvas = rendererScreen;
+   output      *out  = &rendererY4M_output;
+   CANVAS_ASSERT(cvas);
+   assert(cvas.width <= GRID_WIDTH);
+
+   // frames of a Y4M stream can't change their size
+   if (cvas.width  != rendererY4M_width ||
+       cvas.height != rendererY4M_height)
+      return -1;
+   TRACE_BEGIN("rendererY4M_render");
+
+   output_write(out, "FRAME\n", CSTR_LENGTH("FRAME\n"));
+
+   // luma plane
+   size_t width = cvas.width * rendererY4M_run; // bytes in a line
+   bool   vectored = output_isVectored(out);
+   unsigned char *frame = rendererY4M_lines;
+   if (vectored) {
+      frame += rendererY4M_parity * GLYPH_HEIGHT * GRID_HEIGHT * width;
+      rendererY4M_parity = !rendererY4M_parity;
+   }
+   for (int y = 0; y < cvas.height; y++) {
+       // bitmap of the row (unless the bitmap of the screen is already made)
+       const unsigned char *row = rendererY4M_bits;
+       if (rendererBitmap)
+          row = rendererBitmap + y * GLYPH_HEIGHT * cvas.width;
+       else
+          bitmap_fromCanvasRow(rendererY4M_bits, cvas.width, cvas, y);
+       for (int line = 0; line < GLYPH_HEIGHT; line++) {
+           const unsigned char *bits = row + line * cvas.width;
+           unsigned char *scanline = (vectored)
+                                   ? frame + (y * GLYPH_HEIGHT + line) * width
+                                   : rendererY4M_lines;
+           unsigned char *line_out = scanline;
+           for (int x = 0; x < cvas.width; x++, line_out += rendererY4M_run)
+               memcpy(line_out, rendererY4M_runs + bits[x] * rendererY4M_run,
+                      rendererY4M_run);
+           if (vectored) {
+              for (int ny = 0; ny < rendererY4M_zoomy; ny++)
+                  output_writeRef(out, scanline, width);
+           } else {
+              for (int ny = 1; ny < rendererY4M_zoomy; ny++)
+                  memcpy(scanline + ny * width, scanline, width);
+              output_write(out, scanline, rendererY4M_zoomy * width);
+           }
+       }
+   }
+
+   // chroma planes (Cb and Cr)
+   output_writeRef(out, rendererY4M_chroma, rendererY4M_chromaSize);
+   output_writeRef(out, rendererY4M_chroma, rendererY4M_chromaSize);
+
+   // end the frame (write it, or queue it)
+   int err = output_submit(out);
+   TRACE_END("rendererY4M_render");
+   return err;
+}
+
+// `drop` function for the Y4M renderer
+static int
+rendererY4M_drop(void)
+{
+   output_drop(&rendererY4M_output);
+   free(rendererY4M_runs);
+   free(rendererY4M_lines);
+   free(rendererY4M_chroma);
+   rendererY4M_runs   = NULL;
+   rendererY4M_lines  = NULL;
+   rendererY4M_chroma = NULL;
+   return 0;
+}
+
+int rendererY4M_init(int fps, int zoomx, int zoomy)
+{
+   // (same zoom limits as the PPM renderer)
+   if ((fps   <= 0) || (fps   > 1000))  fps   = 60;
+   if ((zoomx <= 0) || (zoomx > 20))    zoomx = 3;
+   if ((zoomy <= 0) || (zoomy > 20))    zoomy = 3;
+
+   // drop the active renderer (we can't do error checking)
+   renderer_drop();
+   rendererSingleton.error  = 0;
+
+   // allocate the lookup table and the buffers, for the screen which will be
+   // rendered (dimensions are multiple of 8, so the 4:2:0 chroma planes are
+   // exactly a quarter of the luma plane)
+   int    width  = zoomx * GLYPH_WIDTH  * screen.width;
+   int    height = zoomy * GLYPH_HEIGHT * screen.height;
+   size_t run    = GLYPH_WIDTH * zoomx;
+   rendererY4M_chromaSize = (size_t)(width / 2) * (height / 2);
+   if (output_init(&rendererY4M_output, RENDERER_Y4M_STREAM,
+                   6 + (size_t)width * height + 2 * rendererY4M_chromaSize))
+      return -1;
+   size_t lines = (output_isVectored(&rendererY4M_output))
+                  ? 2 * GLYPH_HEIGHT * GRID_HEIGHT : zoomy;
+   rendererY4M_runs   = malloc(256 * run);
+   rendererY4M_lines  = malloc(lines * GRID_WIDTH * run);
+   rendererY4M_chroma = malloc(rendererY4M_chromaSize);
+   if (rendererY4M_runs == NULL || rendererY4M_lines == NULL ||
+       rendererY4M_chroma == NULL) {
+      rendererY4M_drop();
+      return -1;
+   }
+   rendererY4M_parity = 0;
+
+   // output the stream header (directly, as it must not be dropped)
+   fprintf(RENDERER_Y4M_STREAM, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+           width, height, fps);
+   rendererY4M_zoomx  = zoomx;
+   rendererY4M_zoomy  = zoomy;
+   rendererY4M_run    = run;
+   rendererY4M_width  = screen.width;
+   rendererY4M_height = screen.height;
+
+   // fill the lookup table, and the neutral chroma
+   for (int byte = 0; byte < 256; byte++)
+       for (int i = 0; i < GLYPH_WIDTH * zoomx; i++)
+           rendererY4M_runs[byte * run + i] =
+               (byte & (0x80 >> (i / zoomx))) ? RENDERER_Y4M_FG
+                                              : RENDERER_Y4M_BG;
+   memset(rendererY4M_chroma, 128, rendererY4M_chromaSize);
+
+   // set the active render
+   rendererSingleton.id     = RENDERER_Y4M;
+   rendererSingleton.render = &rendererY4M_render;
+   rendererSingleton.drop   = &rendererY4M_drop;
+   render();
+   return 0;
+}
+
+#endif //RENDERER_Y4M
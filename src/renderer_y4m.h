@@ -0,0 +1,38 @@
+/*******************************************************************************
+ * @file
+ * The Y4M renderer prints the canvas on C standard output as a YUV4MPEG2 video
+ * stream: a stream header (with the dimensions and the frame rate) followed by
+ * one frame for each `render()`.
+ * see: https://wiki.multimedia.cx/index.php/YUV4MPEG2
+ *
+ * Contrary to a series of PPM images, media players and encoders take this as
+ * a proper video, for example: `... | mpv -` or `... | ffmpeg -i - out.mp4`
+ ******************************************************************************/
+#ifndef  KONPU_RENDERER_Y4M_H
+#define  KONPU_RENDERER_Y4M_H
+#include "platform.h"
+#include "c.h"
+
+#if KONPU_PLATFORM_LIBC
+#   define RENDERER_Y4M        5
+
+/// @brief  initialize the "Y4M" renderer (and output the stream header)
+///         The video has the dimensions of the screen at that time; later,
+///         rendering a screen with other dimensions fails (and writes nothing)
+/// @param  fps   frame rate of the video (in frames per second).
+///               When not in [1-1000], Konpu chooses a default value (60).
+/// @param  zoomx how much to zoom (in the x direction).
+/// @param  zoomy how much to zoom (in the y direction).
+///         When the given values of zoomx and zoomy are not in [1-20],
+///         Konpu will choose some default sensible value instead.
+/// @return 0 iff initialization if successful
+///         (it may only fail if the renderer can't allocate its buffers
+///          or set up its output, see `output_configure`)
+int rendererY4M_init(int fps, int zoomx, int zoomy);
+
+#else
+#   define RENDERER_Y4M                        0
+#   define rendererY4M_init(fps, zoomx, zoomy) 1
+
+#endif //KONPU_PLATFORM_LIBC
+#endif //KONPU_RENDERER_Y4M_H
@@ -8,3 +8,18 @@ canvas screen = { .glyphs = konpu_framebuffer,
                   .width  = GRID_WIDTH,
                   .height = GRID_HEIGHT,
                   .stride = GRID_WIDTH };
+
+// canvas painted by the renderers:
+canvas rendererScreen = { .glyphs = konpu_framebuffer,
+                          .width  = GRID_WIDTH,
+                          .height = GRID_HEIGHT,
+                          .stride = GRID_WIDTH };
+
+// bitmap of the canvas painted by the renderers (if any):
+const unsigned char *rendererBitmap = NULL;
+
+// colors of the screen:
+glyphColors screenColors[GRID_WIDTH * GRID_HEIGHT];
+
+// colors painted by the renderers:
+glyphColors *rendererColors = screenColors;
@@ -8,6 +8,16 @@
 #include "canvas.h"
 extern canvas screen; // global canvas
 
+// canvas painted by the renderers: this is the `screen`, except when rendering
+// asynchronously (see `renderer_async()`) where renderers paint a snapshot of it
+extern canvas rendererScreen;
+
+// bitmap of the `rendererScreen` (see bitmap.h) when it has already been made
+// for this frame (by the fan-out renderer, for all its sinks), or else NULL.
+// Its lines have `rendererScreen.width` bytes, and it's followed by
+// GLYPH_HEIGHT lines of zeros.
+extern const unsigned char *rendererBitmap;
+
 // default screen size: aspect ratio and resolution mode
 // glyph grid   resolution:     (MODE * ASPECT_Y) x (MODE * ASPECT_Y)
 // actual pixel resolution: (8 * MODE * ASPECT_Y) x (8 * MODE * ASPECT_Y)
@@ -34,4 +44,35 @@ extern canvas screen; // global canvas
 
 //===</ SCREEN >================================================================
 
+
+
+//===< COLORS >=================================================================
+
+// colors of a glyph (see below for the values of a color)
+typedef struct glyphColors {
+   uint32_t fg; // color of the pixels which are set
+   uint32_t bg; // color of the pixels which are unset
+} glyphColors;
+
+// colors of the glyphs of the screen, for the renderers which support colors
+// (one per glyph, at the same index as the glyph in `screen.glyphs`)
+extern glyphColors screenColors[GRID_WIDTH * GRID_HEIGHT];
+
+// colors painted by the renderers: those are the `screenColors`, except when
+// rendering asynchronously, where renderers paint a snapshot of them (they
+// are always laid out as the glyphs of `rendererScreen`)
+extern glyphColors *rendererColors;
+
+// values of a color:
+#define COLOR_DEFAULT     UINT32_C(0)   // default color of the renderer
+#define COLOR_RGB(rgb)    (UINT32_C(0x1000000) | ((rgb) & UINT32_C(0xFFFFFF)))
+#define COLOR_INDEX(n)    (UINT32_C(0x2000000) | ((n) & UINT32_C(0xFF)))
+                          // ^-- index in the palette of 256 colors of xterm
+
+#define color_isRGB(color)      ((color) & UINT32_C(0x1000000))
+#define color_isIndex(color)    ((color) & UINT32_C(0x2000000))
+#define color_value(color)      ((color) & UINT32_C(0xFFFFFF)) // (RGB or index)
+
+//===</ COLORS >================================================================
+
 #endif //KONPU_SCREEN_H
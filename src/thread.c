@@ -0,0 +1,92 @@
+#include "thread.h"
+#include "trace.h"
+
+#if THREAD_SUPPORT
+// threads start by running their function through this, so that they can
+// release their resources (their trace ring) when they end
+static int thread_run(void *t)
+{ int ret = (*((thread*)t)->function)(((thread*)t)->arg);
+  trace_release();
+  return ret; }
+#endif
+
+#if KONPU_PLATFORM_SDL2
+
+int  thread_create(thread *t, int (*function)(void*), void *arg)
+{ t->function = function;
+  t->arg      = arg;
+  t->handle   = SDL_CreateThread(&thread_run, "konpu", t);
+  return (t->handle == NULL); }
+void thread_join(thread *t)               { SDL_WaitThread(t->handle, NULL); }
+
+int  mutex_init(mutex *m)                 { *m = SDL_CreateMutex(); return (*m == NULL); }
+void mutex_drop(mutex *m)                 { SDL_DestroyMutex(*m); }
+void mutex_lock(mutex *m)                 { SDL_LockMutex(*m); }
+void mutex_unlock(mutex *m)               { SDL_UnlockMutex(*m); }
+
+int  condition_init(condition *c)         { *c = SDL_CreateCond(); return (*c == NULL); }
+void condition_drop(condition *c)         { SDL_DestroyCond(*c); }
+void condition_wait(condition *c, mutex *m) { SDL_CondWait(*c, *m); }
+void condition_signal(condition *c)       { SDL_CondSignal(*c); }
+void condition_broadcast(condition *c)    { SDL_CondBroadcast(*c); }
+
+#elif KONPU_PLATFORM_POSIX
+
+// pthreads' functions return a pointer, so start them through this
+static void* thread_start(void *t)
+{ return (void*)(intptr_t)thread_run(t); }
+
+int  thread_create(thread *t, int (*function)(void*), void *arg)
+{ t->function = function;
+  t->arg      = arg;
+  return pthread_create(&t->handle, NULL, &thread_start, t); }
+void thread_join(thread *t)               { pthread_join(t->handle, NULL); }
+
+int  mutex_init(mutex *m)                 { return pthread_mutex_init(m, NULL); }
+void mutex_drop(mutex *m)                 { pthread_mutex_destroy(m); }
+void mutex_lock(mutex *m)                 { pthread_mutex_lock(m); }
+void mutex_unlock(mutex *m)               { pthread_mutex_unlock(m); }
+
+int  condition_init(condition *c)         { return pthread_cond_init(c, NULL); }
+void condition_drop(condition *c)         { pthread_cond_destroy(c); }
+void condition_wait(condition *c, mutex *m) { pthread_cond_wait(c, m); }
+void condition_signal(condition *c)       { pthread_cond_signal(c); }
+void condition_broadcast(condition *c)    { pthread_cond_broadcast(c); }
+
+#elif THREAD_SUPPORT // C11 threads
+
+int  thread_create(thread *t, int (*function)(void*), void *arg)
+{ t->function = function;
+  t->arg      = arg;
+  return thrd_create(&t->handle, &thread_run, t) != thrd_success; }
+void thread_join(thread *t)               { thrd_join(t->handle, NULL); }
+
+int  mutex_init(mutex *m)                 { return mtx_init(m, mtx_plain) != thrd_success; }
+void mutex_drop(mutex *m)                 { mtx_destroy(m); }
+void mutex_lock(mutex *m)                 { mtx_lock(m); }
+void mutex_unlock(mutex *m)               { mtx_unlock(m); }
+
+int  condition_init(condition *c)         { return cnd_init(c) != thrd_success; }
+void condition_drop(condition *c)         { cnd_destroy(c); }
+void condition_wait(condition *c, mutex *m) { cnd_wait(c, m); }
+void condition_signal(condition *c)       { cnd_signal(c); }
+void condition_broadcast(condition *c)    { cnd_broadcast(c); }
+
+#else // no threads: everything fails or does nothing
+
+int  thread_create(thread *t, int (*function)(void*), void *arg)
+{ (void)t; (void)function; (void)arg; return -1; }
+void thread_join(thread *t)               { (void)t; }
+
+int  mutex_init(mutex *m)                 { (void)m; return -1; }
+void mutex_drop(mutex *m)                 { (void)m; }
+void mutex_lock(mutex *m)                 { (void)m; }
+void mutex_unlock(mutex *m)               { (void)m; }
+
+int  condition_init(condition *c)         { (void)c; return -1; }
+void condition_drop(condition *c)         { (void)c; }
+void condition_wait(condition *c, mutex *m) { (void)c; (void)m; }
+void condition_signal(condition *c)       { (void)c; }
+void condition_broadcast(condition *c)    { (void)c; }
+
+#endif
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * @file
+ * A minimal portable layer over the threads of the platform (SDL2, POSIX, or
+ * C11 threads) and atomic integers, for the few places where Konpu uses threads
+ * internally, such as renderers which may spread their work or run in the
+ * background.
+ *
+ * THREAD_SUPPORT is set to a non-zero value iff threads are available, and
+ * otherwise those functions always fail. Functions returning an int return 0
+ * iff they succeed.
+ ******************************************************************************/
+#ifndef  KONPU_THREAD_H
+#define  KONPU_THREAD_H
+#include "platform.h"
+#include "c.h"
+
+#if KONPU_PLATFORM_SDL2
+#   define THREAD_SUPPORT   1
+    typedef struct thread { SDL_Thread *handle;
+                            int       (*function)(void*);
+                            void       *arg; } thread;
+    typedef SDL_mutex       *mutex;
+    typedef SDL_cond        *condition;
+#elif KONPU_PLATFORM_POSIX
+#   include <pthread.h>
+#   define THREAD_SUPPORT   1
+    typedef struct thread { pthread_t handle;
+                            int     (*function)(void*);
+                            void     *arg; } thread;
+    typedef pthread_mutex_t  mutex;
+    typedef pthread_cond_t   condition;
+#elif KONPU_PLATFORM_LIBC && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+#   include <threads.h>
+#   define THREAD_SUPPORT   1
+    typedef struct thread { thrd_t handle;
+                            int  (*function)(void*);
+                            void  *arg; } thread;
+    typedef mtx_t            mutex;
+    typedef cnd_t            condition;
+#else
+#   define THREAD_SUPPORT   0
+    typedef struct thread { int handle; } thread;
+    typedef int              mutex;
+    typedef int              condition;
+#endif
+
+// atomic integers:
+#if KONPU_PLATFORM_SDL2
+    typedef SDL_atomic_t     atomicInt;
+#elif (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#   include <stdatomic.h>
+    typedef atomic_int       atomicInt;
+#elif defined(__GNUC__)
+    typedef struct atomicInt { int value; } atomicInt; // (with GCC's builtins)
+#else
+    typedef struct atomicInt { int value; } atomicInt; // (not atomic!)
+#endif
+
+
+// threads:
+// start a thread executing `function(arg)` (the thread object must remain valid
+// until the thread is joined), or wait for it to finish.
+int   thread_create(thread *t, int (*function)(void*), void *arg);
+void  thread_join(thread *t);
+
+// mutexes:
+int   mutex_init(mutex *m);
+void  mutex_drop(mutex *m);
+void  mutex_lock(mutex *m);
+void  mutex_unlock(mutex *m);
+
+// condition variables:
+int   condition_init(condition *c);
+void  condition_drop(condition *c);
+void  condition_wait(condition *c, mutex *m);
+void  condition_signal(condition *c);
+void  condition_broadcast(condition *c);
+
+// atomic integers:
+// those are sequentially consistent. `atomicInt_exchange` and `atomicInt_add`
+// return the previous value.
+static inline int   atomicInt_load(atomicInt *a);
+static inline void  atomicInt_store(atomicInt *a, int value);
+static inline int   atomicInt_exchange(atomicInt *a, int value);
+static inline int   atomicInt_add(atomicInt *a, int value);
+
+
+//--- inline implementation ----------------------------------------------------
+
+#if KONPU_PLATFORM_SDL2
+   static inline int  atomicInt_load(atomicInt *a)            { return SDL_AtomicGet(a); }
+   static inline void atomicInt_store(atomicInt *a, int v)    { SDL_AtomicSet(a, v); }
+   static inline int  atomicInt_exchange(atomicInt *a, int v) { return SDL_AtomicSet(a, v); }
+   static inline int  atomicInt_add(atomicInt *a, int v)      { return SDL_AtomicAdd(a, v); }
+#elif (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+   static inline int  atomicInt_load(atomicInt *a)            { return atomic_load(a); }
+   static inline void atomicInt_store(atomicInt *a, int v)    { atomic_store(a, v); }
+   static inline int  atomicInt_exchange(atomicInt *a, int v) { return atomic_exchange(a, v); }
+   static inline int  atomicInt_add(atomicInt *a, int v)      { return atomic_fetch_add(a, v); }
+#elif defined(__GNUC__)
+   static inline int  atomicInt_load(atomicInt *a)            { return __atomic_load_n(&a->value, __ATOMIC_SEQ_CST); }
+   static inline void atomicInt_store(atomicInt *a, int v)    { __atomic_store_n(&a->value, v, __ATOMIC_SEQ_CST); }
+   static inline int  atomicInt_exchange(atomicInt *a, int v) { return __atomic_exchange_n(&a->value, v, __ATOMIC_SEQ_CST); }
+   static inline int  atomicInt_add(atomicInt *a, int v)      { return __atomic_fetch_add(&a->value, v, __ATOMIC_SEQ_CST); }
+#else
+   static inline int  atomicInt_load(atomicInt *a)            { return a->value; }
+   static inline void atomicInt_store(atomicInt *a, int v)    { a->value = v; }
+   static inline int  atomicInt_exchange(atomicInt *a, int v) { int old = a->value; a->value = v; return old; }
+   static inline int  atomicInt_add(atomicInt *a, int v)      { int old = a->value; a->value += v; return old; }
+#endif
+
+#endif //KONPU_THREAD_H
@@ -0,0 +1,155 @@
+#include "trace.h"
+#if KONPU_TRACE && KONPU_PLATFORM_LIBC
+#include <stdlib.h>
+
+// ring of the current thread
+#if __STDC_VERSION__ >= 201112L
+   _Thread_local traceRing *trace_ring;
+#else
+   __thread      traceRing *trace_ring;
+#endif
+
+// the rings, and the state of their slots: 0 if there's no ring yet, or else
+// if it's used by a thread (TRACE_USED) or released for reuse (TRACE_FREE).
+// (a released ring keeps its events until another thread reuses it)
+#define TRACE_USED   1
+#define TRACE_FREE   2
+static traceRing *trace_rings[TRACE_MAX_THREADS];
+static atomicInt  trace_slots[TRACE_MAX_THREADS];
+static atomicInt  trace_tids;     // number of thread ids given so far
+static atomicInt  trace_releases; // number of rings released so far
+
+// time origin of the trace, in ticks and in ns (to convert ticks to time),
+// set once before the first ring is published (`trace_origin` is then 2)
+static uint64_t   trace_originTicks, trace_originNs;
+static atomicInt  trace_origin;
+
+static void trace_setOrigin(void)
+{
+   if (atomicInt_load(&trace_origin) == 2)
+      return;
+   int state = atomicInt_exchange(&trace_origin, 1);
+   if (state != 1) {
+      if (state == 0) {
+         trace_originTicks = trace_ticks();
+         trace_originNs    = clock_ns();
+      }
+      atomicInt_store(&trace_origin, 2);
+   } else {
+      while (atomicInt_load(&trace_origin) != 2)
+         ; // (another thread is setting it)
+   }
+}
+
+// claim a slot: return its ring, or NULL if it's used (or can't be allocated)
+static traceRing* trace_claim(int i)
+{
+   int state = atomicInt_exchange(&trace_slots[i], TRACE_USED);
+   if (state == TRACE_USED)
+      return NULL;
+
+   traceRing *ring = trace_rings[i];
+   if (state == 0) {
+      ring = calloc(1, sizeof(traceRing));
+      if (ring == NULL) {
+         atomicInt_store(&trace_slots[i], 0);
+         return NULL;
+      }
+      ring->slot     = i;
+      trace_rings[i] = ring;
+   } else {
+      // reuse a released ring (forgetting its events)
+      atomicInt_store(&ring->full, 0);
+      atomicInt_store(&ring->head, 0);
+   }
+   return ring;
+}
+
+traceRing* trace_register(void)
+{
+   trace_setOrigin();
+
+   // take an empty slot first, so that the released rings keep their events
+   traceRing *ring = NULL;
+   for (int i = 0; i < TRACE_MAX_THREADS && ring == NULL; i++)
+       if (atomicInt_load(&trace_slots[i]) == 0)
+          ring = trace_claim(i);
+
+   // or else, reuse the ring which was released first
+   while (ring == NULL) {
+      int oldest = -1, oldestRelease = 0;
+      for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+          if (atomicInt_load(&trace_slots[i]) != TRACE_FREE)
+             continue;
+          int release = atomicInt_load(&trace_rings[i]->release);
+          if (oldest < 0 || release < oldestRelease) {
+             oldest        = i;
+             oldestRelease = release;
+          }
+      }
+      if (oldest < 0)
+         return NULL;
+      ring = trace_claim(oldest); // (NULL if another thread claimed it first)
+   }
+
+   ring->tid  = atomicInt_add(&trace_tids, 1) + 1;
+   trace_ring = ring;
+   return ring;
+}
+
+void trace_release(void)
+{
+   traceRing *ring = trace_ring;
+   if (ring == NULL)
+      return;
+   trace_ring = NULL;
+   atomicInt_store(&ring->release, atomicInt_add(&trace_releases, 1));
+   atomicInt_store(&trace_slots[ring->slot], TRACE_FREE);
+}
+
+void trace_clear(void)
+{
+   for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+       if (atomicInt_load(&trace_slots[i]) == 0 || trace_rings[i] == NULL)
+          continue;
+       atomicInt_store(&trace_rings[i]->full, 0);
+       atomicInt_store(&trace_rings[i]->head, 0);
+   }
+}
+
+int trace_dump(FILE *stream)
+{
+   // nanoseconds per tick (the TSC is calibrated against the clock)
+   double ns_per_tick = 1.;
+#if CPU_X86
+   uint64_t ticks = trace_ticks() - trace_originTicks;
+   uint64_t ns    = clock_ns()    - trace_originNs;
+   if (ticks > 0)   ns_per_tick = (double)ns / ticks;
+#endif
+
+   fputs("{\"traceEvents\":[", stream);
+   bool first = true;
+   for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+       if (atomicInt_load(&trace_slots[i]) == 0)   continue;
+       const traceRing *ring = trace_rings[i];
+       if (ring == NULL)   continue;
+
+       // events from the oldest to the latest
+       int head  = atomicInt_load((atomicInt *)&ring->head);
+       int size  = atomicInt_load((atomicInt *)&ring->full) ? TRACE_EVENTS : head;
+       int index = (head - size) & (TRACE_EVENTS - 1);
+       for (int n = 0; n < size; n++, index = (index + 1) & (TRACE_EVENTS - 1)) {
+           const traceEvent *event = ring->events + index;
+           double us = (double)(int64_t)(event->ticks - trace_originTicks)
+                     * ns_per_tick / 1e3;
+           fprintf(stream, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                           "\"pid\":1,\"tid\":%d}",
+                   (first) ? "" : ",", event->name, event->phase, us, ring->tid);
+           first = false;
+       }
+   }
+   fputs("\n],\"displayTimeUnit\":\"ns\"}\n", stream);
+   return (fflush(stream) || ferror(stream)) ? -1 : 0;
+}
+
+#endif //KONPU_TRACE && KONPU_PLATFORM_LIBC
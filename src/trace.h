@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * @file
+ * Tracing zones, to see where the time of a frame goes: the code between
+ * `TRACE_BEGIN(name)` and `TRACE_END(name)` is a zone, and the begin/end events
+ * are timestamped (with the TSC on x86, or else the monotonic clock) into a
+ * ring buffer of the thread, which only keeps the latest TRACE_EVENTS events.
+ * Then `trace_dump` writes the events of all threads in the Chrome trace event
+ * format (JSON), to be opened in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Tracing is compiled out unless KONPU_TRACE is defined to a non-zero value:
+ * the macros then expand to nothing.
+ *
+ * Usage:
+ *    TRACE_BEGIN("physics");
+ *    ...
+ *    TRACE_END("physics");
+ *    ...
+ *    trace_dump(file);
+ ******************************************************************************/
+#ifndef  KONPU_TRACE_H
+#define  KONPU_TRACE_H
+#include "platform.h"
+#include "c.h"
+
+/// @brief KONPU_TRACE settings:
+/// non-zero to enable the tracing zones (it requires the C standard library)
+#ifndef    KONPU_TRACE
+#   define KONPU_TRACE   0
+#endif
+
+#if KONPU_TRACE && KONPU_PLATFORM_LIBC
+#include <stdio.h>
+#include "thread.h"
+#include "util.h"
+#if CPU_X86
+#   include <x86intrin.h>
+#endif
+
+/// @brief number of events kept by the ring of a thread (a power of two)
+#ifndef    TRACE_EVENTS
+#   define TRACE_EVENTS        (1 << 14)
+#endif
+/// @brief maximum number of threads which are traced at once (the events of
+///        any other thread are ignored). The ring of a thread is reused by
+///        another thread after it's released (see `trace_release`), but only
+///        once all slots are taken, starting with the ring released first.
+#ifndef    TRACE_MAX_THREADS
+#   define TRACE_MAX_THREADS   16
+#endif
+
+/// @brief  begin/end a zone named by `name`, a string literal (without quotes
+///         or backslashes, as it's written as-is in the JSON)
+#define TRACE_BEGIN(name)      trace_event((name), 'B')
+#define TRACE_END(name)        trace_event((name), 'E')
+
+/// @brief  write the events of all threads (in Chrome trace event format)
+/// @return 0 iff successful
+/// @details The other threads should be idle (eg: between two frames), as an
+///          event being written during the dump may be torn.
+int  trace_dump(FILE *stream);
+
+/// @brief  forget all the events
+/// (with the same restriction as `trace_dump`)
+void trace_clear(void);
+
+/// @brief  release the ring of the current thread, which is about to end, so
+///         that another thread may reuse it (its events are kept until then).
+/// @details The threads started by `thread_create` do it when they end.
+void trace_release(void);
+
+
+//--- inline implementation ----------------------------------------------------
+
+// an event and the ring of events of a thread
+typedef struct traceEvent {
+   const char *name;
+   uint64_t    ticks;
+   char        phase; // 'B' or 'E'
+} traceEvent;
+
+typedef struct traceRing {
+   atomicInt   head;    // index of the next event (published to `trace_dump`)
+   atomicInt   full;    // whether the ring has wrapped around
+   int         tid;     // id of the thread in the trace
+   int         slot;    // index of the ring
+   atomicInt   release; // order of its release (when the thread ended)
+   traceEvent  events[TRACE_EVENTS];
+} traceRing;
+
+// ring of the current thread (NULL until its first event)
+#if __STDC_VERSION__ >= 201112L
+   extern _Thread_local traceRing *trace_ring;
+#else
+   extern __thread      traceRing *trace_ring;
+#endif
+
+// register a ring for the current thread, or return NULL if there's none left
+traceRing* trace_register(void);
+
+// timestamp of an event
+static inline uint64_t trace_ticks(void)
+{
+#if CPU_X86
+   return __rdtsc();
+#else
+   return clock_ns();
+#endif
+}
+
+static inline void trace_event(const char *name, char phase)
+{
+   traceRing *ring = trace_ring;
+   if (unlikely(ring == NULL)) {
+      ring = trace_register();
+      if (ring == NULL)   return;
+   }
+   // (only this thread writes its ring, so there's no need for a lock: the
+   //  event is written first, then published by moving the head)
+   int head = atomicInt_load(&ring->head);
+   traceEvent *event = ring->events + head;
+   event->name  = name;
+   event->phase = phase;
+   event->ticks = trace_ticks();
+   head = (head + 1) & (TRACE_EVENTS - 1);
+   if (head == 0)
+      atomicInt_store(&ring->full, 1);
+   atomicInt_store(&ring->head, head);
+}
+
+#else
+#   define TRACE_BEGIN(name)   ((void)0)
+#   define TRACE_END(name)     ((void)0)
+#   define trace_dump(stream)  ((void)(stream), -1)
+#   define trace_clear()       ((void)0)
+#   define trace_release()     ((void)0)
+#endif
+
+#endif //KONPU_TRACE_H
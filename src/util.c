@@ -8,9 +8,11 @@
 #     else
 #        include <unistd.h>
 #     endif
-#elif KONPU_PLATFORM_LIBC && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+#elif KONPU_PLATFORM_LIBC && (__STDC_VERSION__ >= 201112L)
 #     include <time.h>
-#     include <threads.h>
+#     ifndef __STDC_NO_THREADS__
+#        include <threads.h>
+#     endif
 #endif
 void sleep_ms(int milliseconds)
 {
@@ -43,6 +45,163 @@ void sleep_ms(int milliseconds)
 #endif
 }
 
+uint64_t clock_ns(void)
+{
+#if KONPU_PLATFORM_SDL2
+    uint64_t count = SDL_GetPerformanceCounter();
+    uint64_t freq  = SDL_GetPerformanceFrequency();
+    // (split the conversion in two, so that it doesn't overflow)
+    return (count / freq) * 1000000000u + (count % freq) * 1000000000u / freq;
+
+#elif KONPU_PLATFORM_WINDOWS
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    uint64_t c = (uint64_t)count.QuadPart, f = (uint64_t)freq.QuadPart;
+    return (c / f) * 1000000000u + (c % f) * 1000000000u / f;
+
+#elif KONPU_PLATFORM_POSIX && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+#elif (KONPU_PLATFORM_POSIX || KONPU_PLATFORM_LIBC) && (__STDC_VERSION__ >= 201112L)
+    // C11 only has the calendar time, which is not monotonic (but better than
+    // nothing)
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+#else
+    return 0;
+#endif
+}
+
+// sleep (about) the given number of nanoseconds
+static void sleep_ns(uint64_t ns)
+{
+#if KONPU_PLATFORM_SDL2 || KONPU_PLATFORM_WINDOWS
+    // only millisecond sleeps, so don't oversleep: spinning will do the rest
+    sleep_ms((int)(ns / 1000000u));
+
+#elif KONPU_PLATFORM_POSIX && (_POSIX_C_SOURCE >= 199309L)
+    struct timespec ts = { .tv_sec  = (time_t)(ns / 1000000000u),
+                           .tv_nsec = (long)  (ns % 1000000000u) };
+    nanosleep(&ts, NULL);
+
+#elif KONPU_PLATFORM_LIBC && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+    struct timespec ts = { .tv_sec  = (time_t)(ns / 1000000000u),
+                           .tv_nsec = (long)  (ns % 1000000000u) };
+    thrd_sleep(&ts, NULL);
+
+#else
+    sleep_ms((int)(ns / 1000000u));
+#endif
+}
+
+void sleep_until_ns(uint64_t deadline)
+{
+    uint64_t now = clock_ns();
+    if (now == 0) return; // no clock
+
+    // sleep while we're far from the deadline. The OS may wake us up late,
+    // thus we only sleep until the spinning window, and loop as sleeps may
+    // also be interrupted.
+    while (now < deadline && deadline - now > UTIL_SPIN_NS) {
+        sleep_ns(deadline - now - UTIL_SPIN_NS);
+        uint64_t before = now;
+        now = clock_ns();
+        if (now == before) break; // sleeping didn't make progress
+    }
+
+    // then spin until the deadline
+    while (now < deadline)
+        now = clock_ns();
+}
+
+
+//==============================================================================
+// frame pacing
+
+static struct frameState {
+    uint64_t period;      // target frame duration (in ns), 0 if not pacing
+    uint64_t deadline;    // end of the current frame
+    uint64_t begin;       // when the current frame began
+    uint64_t last;        // when the previous frame ended
+    double   duration;    // previous measured frame duration (in ms)
+    uint64_t measured;    // number of measured frame durations
+    double   jitter;      // sum of the differences between consecutive frames
+    double   work;        // total time spent working in frames (in ms)
+    frameStats stats;
+} frame_state;
+
+void frame_setRate(int fps)
+{
+    frame_state = (struct frameState){0};
+    if (fps > 0) {
+        frame_state.period = 1000000000u / (unsigned)fps;
+        frame_state.stats.period = frame_state.period / 1e6;
+    }
+    frame_begin();
+}
+
+void frame_begin(void)
+{
+    uint64_t now = clock_ns();
+    frame_state.begin    = now;
+    frame_state.deadline = now + frame_state.period;
+}
+
+void frame_end(void)
+{
+    frameStats *stats = &frame_state.stats;
+    uint64_t now = clock_ns();
+    frame_state.work += (now - frame_state.begin) / 1e6;
+
+    // wait, unless we're late (or not pacing)
+    if (frame_state.period > 0) {
+        if (now <= frame_state.deadline) {
+            sleep_until_ns(frame_state.deadline);
+            now = clock_ns();
+        } else {
+            stats->missed++;
+        }
+    }
+
+    // measure the duration since the end of the previous frame
+    if (frame_state.last != 0) {
+        double duration = (now - frame_state.last) / 1e6;
+        uint64_t n = frame_state.measured++;  // durations measured so far
+        if (n == 0 || duration < stats->min)  stats->min = duration;
+        if (n == 0 || duration > stats->max)  stats->max = duration;
+        stats->mean += (duration - stats->mean) / (double)(n + 1);
+        if (n > 0) {
+            double diff = duration - frame_state.duration;
+            frame_state.jitter += (diff < 0) ? -diff : diff;
+        }
+        frame_state.duration = duration;
+    }
+    stats->frames++;
+    frame_state.last = now;
+
+    // begin the next frame: deadlines stay on the grid, unless we're more than
+    // a frame late, in which case we restart from now.
+    frame_state.begin = now;
+    frame_state.deadline += frame_state.period;
+    if (frame_state.deadline <= now)
+        frame_state.deadline = now + frame_state.period;
+}
+
+frameStats frame_getStats(void)
+{
+    frameStats stats = frame_state.stats;
+    if (stats.frames > 0)
+        stats.work = frame_state.work / (double)stats.frames;
+    if (frame_state.measured > 1) // (a difference per pair of durations)
+        stats.jitter = frame_state.jitter / (double)(frame_state.measured - 1);
+    return stats;
+}
+
 
 //==============================================================================
 // STC64 PRNG, I have extracted it from STC,
@@ -20,10 +20,114 @@
 // returns immediately.
 void sleep_ms(int milliseconds);
 
+// monotonic clock (in nanoseconds, from an arbitrary origin)
+// it is meant to measure durations, and is high-resolution when the platform
+// has such a clock. It returns 0 if the platform has no clock at all.
+uint64_t clock_ns(void);
+
+// sleep until the monotonic clock reaches the given `deadline` (in ns)
+// It sleeps for most of the time and then spins for the last
+// UTIL_SPIN_NS nanoseconds, to wake up right on time despite OS scheduling.
+// It returns immediately if the deadline has already passed.
+void sleep_until_ns(uint64_t deadline);
+
+// duration (in ns) before a deadline during which `sleep_until_ns` spins
+#ifndef    UTIL_SPIN_NS
+#   define UTIL_SPIN_NS  300000 // 0.3 ms
+#endif
+
 //===</ time >==================================================================
 
 
 
+//===< frame pacing >===========================================================
+// A frame scheduler that paces a loop at a fixed frame rate: deadlines are
+// set on a fixed grid (a frame which ends late doesn't push back the following
+// ones), and the time to render a frame is taken into account.
+//
+// Usage:
+//    frame_setRate(60);      // 60 frames per second
+//    while (...) {
+//       ...                  // update the screen
+//       render();
+//       frame_end();         // wait for the end of the frame, which also
+//    }                       // begins the next one.
+//
+// (note: if the SDL2 renderer uses vsync, presenting the screen in `render()`
+//        already waits for the display, then you may set the rate to 0)
+
+// statistics about the frames (durations are in milliseconds)
+typedef struct frameStats {
+   uint64_t frames;  // number of frames ended
+   uint64_t missed;  // number of frames which ended after their deadline
+   double   period;  // target frame duration
+   double   mean;    // mean of the measured frame durations
+   double   jitter;  // mean difference between consecutive frame durations
+   double   min;     // shortest measured frame duration
+   double   max;     // longest measured frame duration
+   double   work;    // mean time spent in a frame before `frame_end()`
+} frameStats;
+
+// set the target frame rate (in frames per second) and reset the statistics
+// (if fps <= 0, `frame_end()` doesn't wait, but still measures the frames)
+void frame_setRate(int fps);
+
+// (re)start a frame now: the next deadline is one frame period from now
+// (there's usually no need to call this, as `frame_end()` begins a new frame,
+//  but you can do so after a pause or to measure the work in a frame)
+void frame_begin(void);
+
+// wait until the deadline of the current frame, then begin the next frame.
+// If the deadline has already passed, the frame is counted as missed, and the
+// next frame has a shorter duration to catch up, unless we are more than a frame
+// late, in which case the schedule restarts from now.
+void frame_end(void);
+
+// get the statistics about the frames since the last `frame_setRate()`
+frameStats frame_getStats(void);
+
+//===</ frame pacing >==========================================================
+
+
+
+//===< cpu features >===========================================================
+
+// runtime detection of cpu features (x86 SIMD extensions)
+// those are meant to select at runtime between different kernels of a same
+// routine. If detection isn't supported, they return false, thus the caller
+// should always have a portable fallback.
+static inline bool cpu_hasSSE2(void);
+static inline bool cpu_hasAVX2(void);
+static inline bool cpu_hasBMI2(void);  // (PDEP/PEXT bit manipulations)
+
+// CPU_X86 is set to 1 iff the compiler supports x86 intrinsics, <immintrin.h>
+// and `__attribute__((target(...)))` to compile functions with a given feature
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define CPU_X86   1
+#else
+#   define CPU_X86   0
+#endif
+
+
+//--- inline implementation ----------------------------------------------------
+
+#if CPU_X86
+   static inline bool cpu_hasSSE2(void)
+   { __builtin_cpu_init(); return __builtin_cpu_supports("sse2"); }
+   static inline bool cpu_hasAVX2(void)
+   { __builtin_cpu_init(); return __builtin_cpu_supports("avx2"); }
+   static inline bool cpu_hasBMI2(void)
+   { __builtin_cpu_init(); return __builtin_cpu_supports("bmi2"); }
+#else
+   static inline bool cpu_hasSSE2(void)  { return false; }
+   static inline bool cpu_hasAVX2(void)  { return false; }
+   static inline bool cpu_hasBMI2(void)  { return false; }
+#endif
+
+//===</ cpu features >==========================================================
+
+
+
 //===< PSEUDO RANDOM 64-bits NUMBER GENERATOR (PRNG) >==========================
 // 64 bits PRNG (STC64):
 // (we want to have a 64 bits,so can use it to generate random glyph)